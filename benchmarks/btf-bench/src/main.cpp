@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "syntheticbtf.h"
+
+#include <btfparse/ibtf.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct Options final {
+  std::uint32_t record_count{120000};
+  std::size_t iteration_count{10};
+  bool little_endian{true};
+  std::uint32_t lookup_count{0};
+  bool type_refs{false};
+  btfparse::BTFOptions btf_options;
+  btfparse::PathList path_list;
+};
+
+void showHelp() {
+  std::cerr << "Usage:\n"
+            << "\tbtf-bench [--records N] [--iterations N] [--big-endian] "
+               "[--no-byte-swap]\n"
+            << "\t          [--lazy] [--trusted] [--lookups N] [--type-refs] "
+               "[--threads N]\n"
+            << "\tbtf-bench [--iterations N] [--trusted] [--threads N] "
+               "/sys/kernel/btf/vmlinux [/sys/kernel/btf/btusb]\n";
+}
+
+bool parseOptions(Options &options, int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+
+    if (arg == "--records" && i + 1 < argc) {
+      options.record_count =
+          static_cast<std::uint32_t>(std::stoul(argv[++i]));
+
+    } else if (arg == "--iterations" && i + 1 < argc) {
+      options.iteration_count = std::stoul(argv[++i]);
+
+    } else if (arg == "--big-endian") {
+      options.little_endian = false;
+
+    } else if (arg == "--no-byte-swap") {
+      options.btf_options.byte_swap_type_sections = false;
+
+    } else if (arg == "--lazy") {
+      options.btf_options.lazy = true;
+
+    } else if (arg == "--trusted") {
+      options.btf_options.trusted = true;
+
+    } else if (arg == "--lookups" && i + 1 < argc) {
+      options.lookup_count =
+          static_cast<std::uint32_t>(std::stoul(argv[++i]));
+
+    } else if (arg == "--type-refs") {
+      options.type_refs = true;
+
+    } else if (arg == "--threads" && i + 1 < argc) {
+      options.btf_options.thread_count = std::stoul(argv[++i]);
+
+    } else if (arg.rfind("--", 0) == 0) {
+      return false;
+
+    } else {
+      options.path_list.emplace_back(arg);
+    }
+  }
+
+  return options.iteration_count != 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if ((argc > 1 && std::strcmp(argv[1], "--help") == 0) ||
+      !parseOptions(options, argc, argv)) {
+    showHelp();
+    return 1;
+  }
+
+  std::filesystem::path synthetic_btf_path;
+  if (options.path_list.empty()) {
+    auto buffer =
+        generateSyntheticBTF(options.record_count, options.little_endian);
+
+    synthetic_btf_path =
+        std::filesystem::temp_directory_path() /
+        ("btf-bench-" + std::to_string(options.record_count) + ".btf");
+
+    std::ofstream output(synthetic_btf_path, std::ios::binary);
+    output.write(reinterpret_cast<const char *>(buffer.data()),
+                 static_cast<std::streamsize>(buffer.size()));
+
+    if (!output) {
+      std::cerr << "Failed to write the synthetic BTF file\n";
+      return 1;
+    }
+
+    options.path_list.push_back(synthetic_btf_path);
+
+    std::cout << "Input: synthetic, " << buffer.size() << " bytes, "
+              << (options.little_endian ? "little" : "big") << " endian\n";
+  }
+
+  std::vector<double> sample_list;
+  std::uint32_t type_count{0};
+
+  for (std::size_t i = 0; i < options.iteration_count; ++i) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    auto btf_res = btfparse::IBTF::createFromPathList(options.path_list,
+                                                        options.btf_options);
+    if (btf_res.failed()) {
+      std::cerr << "Failed to open the BTF file: " << btf_res.takeError()
+                << "\n";
+      return 1;
+    }
+
+    auto btf = btf_res.takeValue();
+
+    // Resolve a subset of the types, spread evenly across the ID range
+    if (options.lookup_count != 0) {
+      auto step =
+          std::max<std::uint32_t>(1, btf->count() / options.lookup_count);
+
+      for (std::uint32_t id = 1; id <= btf->count(); id += step) {
+        auto found = options.type_refs
+                         ? static_cast<bool>(btf->getTypeRef(id))
+                         : btf->getType(id).has_value();
+
+        if (!found) {
+          std::cerr << "Failed to resolve type " << id << "\n";
+          return 1;
+        }
+      }
+    }
+
+    auto end_time = std::chrono::steady_clock::now();
+    sample_list.push_back(
+        std::chrono::duration<double>(end_time - start_time).count());
+
+    type_count = btf->count();
+  }
+
+  if (!synthetic_btf_path.empty()) {
+    std::filesystem::remove(synthetic_btf_path);
+  }
+
+  std::sort(sample_list.begin(), sample_list.end());
+
+  auto best_time = sample_list.front();
+  auto median_time = sample_list[sample_list.size() / 2];
+
+  std::cout << "Types: " << type_count << "\n"
+            << "Iterations: " << sample_list.size() << "\n"
+            << "Best: " << (best_time * 1000.0) << " ms ("
+            << static_cast<std::uint64_t>(type_count / best_time)
+            << " records/sec)\n"
+            << "Median: " << (median_time * 1000.0) << " ms ("
+            << static_cast<std::uint64_t>(type_count / median_time)
+            << " records/sec)\n";
+
+  return 0;
+}
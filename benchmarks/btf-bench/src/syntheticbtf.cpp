@@ -0,0 +1,196 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "syntheticbtf.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+enum class Kind : std::uint32_t {
+  Int = 1,
+  Ptr = 2,
+  Array = 3,
+  Struct = 4,
+  Enum = 6,
+  Typedef = 8,
+  Const = 10,
+  Func = 12,
+  FuncProto = 13,
+};
+
+const std::uint32_t kBTFHeaderSize{24U};
+
+class SyntheticBTFBuilder final {
+  bool little_endian{true};
+
+  std::vector<std::uint8_t> type_section;
+  std::vector<std::uint8_t> string_section{0};
+  std::unordered_map<std::string, std::uint32_t> string_map;
+
+  std::uint32_t last_type_id{0};
+
+public:
+  SyntheticBTFBuilder(bool little_endian_) : little_endian(little_endian_) {}
+
+  std::uint32_t count() const { return last_type_id; }
+
+  std::uint32_t addString(const std::string &str) {
+    auto string_map_it = string_map.find(str);
+    if (string_map_it != string_map.end()) {
+      return string_map_it->second;
+    }
+
+    auto offset = static_cast<std::uint32_t>(string_section.size());
+    string_section.insert(string_section.end(), str.begin(), str.end());
+    string_section.push_back(0);
+
+    string_map.insert({str, offset});
+    return offset;
+  }
+
+  std::uint32_t addType(const std::string &name, Kind kind, std::uint32_t vlen,
+                        std::uint32_t size_or_type) {
+
+    auto name_off = name.empty() ? 0U : addString(name);
+    auto info = (static_cast<std::uint32_t>(kind) << 24) | (vlen & 0xFFFFU);
+
+    addU32(type_section, name_off);
+    addU32(type_section, info);
+    addU32(type_section, size_or_type);
+
+    return ++last_type_id;
+  }
+
+  void addData(std::uint32_t value) { addU32(type_section, value); }
+
+  std::vector<std::uint8_t> finalize() const {
+    std::vector<std::uint8_t> output;
+
+    auto type_len = static_cast<std::uint32_t>(type_section.size());
+    auto str_len = static_cast<std::uint32_t>(string_section.size());
+
+    addU16(output, 0xEB9F);
+    output.push_back(1);
+    output.push_back(0);
+    addU32(output, kBTFHeaderSize);
+    addU32(output, 0);
+    addU32(output, type_len);
+    addU32(output, type_len);
+    addU32(output, str_len);
+
+    output.insert(output.end(), type_section.begin(), type_section.end());
+    output.insert(output.end(), string_section.begin(), string_section.end());
+
+    return output;
+  }
+
+private:
+  void addU16(std::vector<std::uint8_t> &buffer, std::uint16_t value) const {
+    if (little_endian) {
+      buffer.push_back(static_cast<std::uint8_t>(value));
+      buffer.push_back(static_cast<std::uint8_t>(value >> 8));
+
+    } else {
+      buffer.push_back(static_cast<std::uint8_t>(value >> 8));
+      buffer.push_back(static_cast<std::uint8_t>(value));
+    }
+  }
+
+  void addU32(std::vector<std::uint8_t> &buffer, std::uint32_t value) const {
+    if (little_endian) {
+      addU16(buffer, static_cast<std::uint16_t>(value));
+      addU16(buffer, static_cast<std::uint16_t>(value >> 16));
+
+    } else {
+      addU16(buffer, static_cast<std::uint16_t>(value >> 16));
+      addU16(buffer, static_cast<std::uint16_t>(value));
+    }
+  }
+};
+
+} // namespace
+
+std::vector<std::uint8_t> generateSyntheticBTF(std::uint32_t record_count,
+                                               bool little_endian) {
+  SyntheticBTFBuilder builder(little_endian);
+
+  auto int_id = builder.addType("int", Kind::Int, 0, 4);
+  builder.addData((1U << 24) | 32U);
+
+  auto char_id = builder.addType("char", Kind::Int, 0, 1);
+  builder.addData((2U << 24) | 8U);
+
+  std::uint32_t struct_id{int_id};
+  std::uint32_t ptr_id{char_id};
+  std::uint32_t func_proto_id{0};
+
+  for (std::uint32_t i = 0; builder.count() < record_count; ++i) {
+    auto suffix = std::to_string(i / 10);
+
+    switch (i % 10) {
+    case 0:
+      struct_id = builder.addType("struct_" + suffix, Kind::Struct, 8, 32);
+      for (std::uint32_t k = 0; k < 8; ++k) {
+        builder.addData(builder.addString("field_" + std::to_string(k)));
+        builder.addData(k % 2 == 0 ? int_id : ptr_id);
+        builder.addData(k * 32);
+      }
+
+      break;
+
+    case 1:
+      ptr_id = builder.addType("", Kind::Ptr, 0, struct_id);
+      break;
+
+    case 2:
+      builder.addType("", Kind::Const, 0, ptr_id);
+      break;
+
+    case 3:
+      builder.addType("typedef_" + suffix, Kind::Typedef, 0, struct_id);
+      break;
+
+    case 4:
+    case 6:
+      func_proto_id = builder.addType("", Kind::FuncProto, 3, int_id);
+      for (std::uint32_t k = 0; k < 3; ++k) {
+        builder.addData(builder.addString("arg" + std::to_string(k)));
+        builder.addData(k == 0 ? ptr_id : int_id);
+      }
+
+      break;
+
+    case 5:
+    case 7:
+      builder.addType("func_" + std::to_string(i), Kind::Func, 1,
+                      func_proto_id);
+      break;
+
+    case 8:
+      builder.addType("enum_" + suffix, Kind::Enum, 6, 4);
+      for (std::uint32_t k = 0; k < 6; ++k) {
+        builder.addData(
+            builder.addString("ENUM_" + suffix + "_" + std::to_string(k)));
+        builder.addData(k);
+      }
+
+      break;
+
+    case 9:
+      builder.addType("", Kind::Array, 0, 0);
+      builder.addData(char_id);
+      builder.addData(int_id);
+      builder.addData(16);
+      break;
+    }
+  }
+
+  return builder.finalize();
+}
@@ -0,0 +1,18 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Generates a BTF blob containing `record_count` types, using a mix of kinds
+// that roughly follows the one found in a vmlinux image (mostly functions,
+// prototypes and structures)
+std::vector<std::uint8_t> generateSyntheticBTF(std::uint32_t record_count,
+                                               bool little_endian);
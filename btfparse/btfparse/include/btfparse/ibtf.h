@@ -8,13 +8,17 @@
 
 #pragma once
 
+#include <btfparse/bytespan.h>
 #include <btfparse/error.h>
+#include <btfparse/istream.h>
 #include <btfparse/result.h>
 
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <sstream>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -43,6 +47,12 @@ struct BTFErrorInformation final {
     InvalidVarBTFTypeEncoding,
     InvalidDataSecBTFTypeEncoding,
     InvalidStringOffset,
+    InvalidELFImage,
+    SectionNotFound,
+    UnsupportedCompressionFormat,
+    DecompressionError,
+    BaseBTFNotAvailable,
+    InvalidTypeReference,
   };
 
   struct FileRange final {
@@ -145,6 +155,30 @@ struct BTFErrorInformationPrinter final {
     case BTFErrorInformation::Code::InvalidStringOffset:
       buffer << "Invalid string offset";
       break;
+
+    case BTFErrorInformation::Code::InvalidELFImage:
+      buffer << "Invalid ELF image";
+      break;
+
+    case BTFErrorInformation::Code::SectionNotFound:
+      buffer << "The .BTF section was not found";
+      break;
+
+    case BTFErrorInformation::Code::UnsupportedCompressionFormat:
+      buffer << "Unsupported compression format";
+      break;
+
+    case BTFErrorInformation::Code::DecompressionError:
+      buffer << "Failed to decompress the input file";
+      break;
+
+    case BTFErrorInformation::Code::BaseBTFNotAvailable:
+      buffer << "The base BTF data is not available";
+      break;
+
+    case BTFErrorInformation::Code::InvalidTypeReference:
+      buffer << "A type refers to a type ID that does not exist";
+      break;
     }
 
     buffer << "'";
@@ -161,6 +195,9 @@ struct BTFErrorInformationPrinter final {
 
 using BTFError = Error<BTFErrorInformation, BTFErrorInformationPrinter>;
 
+// Type names point inside the string sections retained by the IBTF object
+// they were obtained from, and must not outlive it. The names of the types
+// of a split BTF file are only valid until the file is detached
 struct IntBTFType final {
   enum class Encoding {
     None,
@@ -169,7 +206,7 @@ struct IntBTFType final {
     Bool,
   };
 
-  std::string name;
+  std::string_view name;
   std::uint32_t size{};
   Encoding encoding{Encoding::None};
 
@@ -192,26 +229,26 @@ struct ArrayBTFType final {
 };
 
 struct TypedefBTFType final {
-  std::string name;
+  std::string_view name;
   std::uint32_t type{};
 };
 
 struct EnumBTFType final {
   struct Value final {
-    std::string name;
+    std::string_view name;
     std::int32_t val{};
   };
 
   using ValueList = std::vector<Value>;
 
-  std::optional<std::string> opt_name;
+  std::optional<std::string_view> opt_name;
   std::uint32_t size{};
   ValueList value_list;
 };
 
 struct FuncProtoBTFType final {
   struct Param final {
-    std::optional<std::string> opt_name;
+    std::optional<std::string_view> opt_name;
     std::uint32_t type{};
   };
 
@@ -228,7 +265,7 @@ struct VolatileBTFType final {
 
 struct StructBTFType final {
   struct Member final {
-    std::optional<std::string> opt_name;
+    std::optional<std::string_view> opt_name;
     std::uint32_t type{};
     std::uint32_t offset{};
     std::optional<std::uint8_t> opt_bitfield_size;
@@ -236,14 +273,14 @@ struct StructBTFType final {
 
   using MemberList = std::vector<Member>;
 
-  std::optional<std::string> opt_name;
+  std::optional<std::string_view> opt_name;
   std::uint32_t size{};
   MemberList member_list;
 };
 
 struct UnionBTFType final {
   struct Member final {
-    std::optional<std::string> opt_name;
+    std::optional<std::string_view> opt_name;
     std::uint32_t type{};
     std::uint32_t offset{};
     std::optional<std::uint8_t> opt_bitfield_size;
@@ -251,13 +288,13 @@ struct UnionBTFType final {
 
   using MemberList = std::vector<Member>;
 
-  std::optional<std::string> opt_name;
+  std::optional<std::string_view> opt_name;
   std::uint32_t size{};
   MemberList member_list;
 };
 
 struct FwdBTFType final {
-  std::string name;
+  std::string_view name;
   bool is_union{false};
 };
 
@@ -268,13 +305,13 @@ struct FuncBTFType final {
     Extern = 2,
   };
 
-  std::string name;
+  std::string_view name;
   std::uint32_t type{};
   Linkage linkage{Linkage::Static};
 };
 
 struct FloatBTFType final {
-  std::string name;
+  std::string_view name;
   std::uint32_t size{};
 };
 
@@ -283,7 +320,7 @@ struct RestrictBTFType final {
 };
 
 struct VarBTFType final {
-  std::string name;
+  std::string_view name;
   std::uint32_t type{};
   std::uint32_t linkage{};
 };
@@ -297,7 +334,7 @@ struct DataSecBTFType final {
 
   using VariableList = std::vector<Variable>;
 
-  std::string name;
+  std::string_view name;
   std::uint32_t size{};
   VariableList variable_list;
 };
@@ -330,24 +367,382 @@ using BTFType =
                  FloatBTFType>;
 
 using BTFTypeMap = std::unordered_map<std::uint32_t, BTFType>;
+
+class BTF;
+class BTFTypeTable;
+
+// The BTF*Ref handles read a type in place, from the IBTF object that
+// returned them, instead of copying it like getType() does. They are small
+// enough to be passed by value, and remain valid for as long as the object
+// does, or until detach() is called for the types of a split BTF file
+
+// A member of a struct or union
+class BTFMemberRef final {
+public:
+  BTFMemberRef() = default;
+
+  std::optional<std::string_view> name() const noexcept;
+  std::uint32_t type() const noexcept;
+  std::uint32_t offset() const noexcept;
+  std::optional<std::uint8_t> bitfieldSize() const noexcept;
+
+private:
+  const BTFTypeTable *table{nullptr};
+  std::uint32_t index{};
+
+  BTFMemberRef(const BTFTypeTable *table_, std::uint32_t index_) noexcept
+      : table(table_), index(index_) {}
+
+  friend class BTFStructRef;
+};
+
+// A struct or union
+class BTFStructRef final {
+public:
+  BTFStructRef() = default;
+
+  std::uint32_t id() const noexcept { return type_id; }
+  bool isUnion() const noexcept;
+
+  std::optional<std::string_view> name() const noexcept;
+  std::uint32_t size() const noexcept;
+
+  std::size_t memberCount() const noexcept { return member_count; }
+
+  // `index` must be less than memberCount()
+  BTFMemberRef member(std::size_t index) const noexcept {
+    return BTFMemberRef(table,
+                        first_member + static_cast<std::uint32_t>(index));
+  }
+
+private:
+  const BTFTypeTable *table{nullptr};
+  std::uint32_t type_id{};
+  std::uint32_t first_member{};
+  std::uint32_t member_count{};
+
+  BTFStructRef(const BTFTypeTable *table_, std::uint32_t type_id_) noexcept;
+
+  friend class BTFTypeRef;
+};
+
+// A type of any kind. The handles returned for type IDs that do not exist
+// are empty, and their other methods must not be called
+class BTFTypeRef final {
+public:
+  BTFTypeRef() = default;
+
+  explicit operator bool() const noexcept { return table != nullptr; }
+
+  std::uint32_t id() const noexcept { return type_id; }
+  BTFKind kind() const noexcept;
+
+  // Empty for anonymous types, and for the kinds that have no name
+  std::optional<std::string_view> name() const noexcept;
+
+  // The type that Ptr, Const, Volatile, Restrict, Typedef, Func and Var
+  // types refer to, the element type of an Array, or the return type of a
+  // FuncProto
+  std::optional<std::uint32_t> type() const noexcept;
+
+  // The size of Int, Struct, Union, Enum, DataSec and Float types
+  std::optional<std::uint32_t> size() const noexcept;
+
+  // Empty unless the type is a struct or a union
+  std::optional<BTFStructRef> asStruct() const noexcept;
+
+private:
+  const BTFTypeTable *table{nullptr};
+  std::uint32_t type_id{};
+
+  BTFTypeRef(const BTFTypeTable *table_, std::uint32_t type_id_) noexcept
+      : table(table_), type_id(type_id_) {}
+
+  friend class BTF;
+};
+
+// Read-only view over a list of records, used by the BTFTypeView types
+template <typename Type> class BTFListView final {
+  const Type *list_data{nullptr};
+  std::size_t list_size{0};
+
+public:
+  BTFListView() = default;
+
+  BTFListView(const Type *data, std::size_t size) noexcept
+      : list_data(data), list_size(size) {}
+
+  const Type *data() const noexcept { return list_data; }
+  std::size_t size() const noexcept { return list_size; }
+  bool empty() const noexcept { return list_size == 0; }
+
+  const Type *begin() const noexcept { return list_data; }
+  const Type *end() const noexcept { return list_data + list_size; }
+
+  const Type &operator[](std::size_t index) const noexcept {
+    return list_data[index];
+  }
+
+  const Type &back() const noexcept { return list_data[list_size - 1]; }
+};
+
+// The BTFTypeView types are the counterparts of the BTFType ones that are
+// passed to the IBTF::scan() visitor. Names point inside the string
+// section, and lists point to storage that is reused for the next record:
+// neither must be retained after the visitor returns
+struct IntBTFTypeView final {
+  std::string_view name;
+  std::uint32_t size{};
+  IntBTFType::Encoding encoding{IntBTFType::Encoding::None};
+
+  std::uint8_t offset{};
+  std::uint8_t bits{};
+};
+
+struct TypedefBTFTypeView final {
+  std::string_view name;
+  std::uint32_t type{};
+};
+
+struct EnumBTFTypeView final {
+  struct Value final {
+    std::string_view name;
+    std::int32_t val{};
+  };
+
+  using ValueList = BTFListView<Value>;
+
+  std::optional<std::string_view> opt_name;
+  std::uint32_t size{};
+  ValueList value_list;
+};
+
+struct FuncProtoBTFTypeView final {
+  struct Param final {
+    std::optional<std::string_view> opt_name;
+    std::uint32_t type{};
+  };
+
+  using ParamList = BTFListView<Param>;
+
+  std::uint32_t return_type{};
+  ParamList param_list;
+  bool is_variadic{false};
+};
+
+struct StructBTFTypeView final {
+  struct Member final {
+    std::optional<std::string_view> opt_name;
+    std::uint32_t type{};
+    std::uint32_t offset{};
+    std::optional<std::uint8_t> opt_bitfield_size;
+  };
+
+  using MemberList = BTFListView<Member>;
+
+  std::optional<std::string_view> opt_name;
+  std::uint32_t size{};
+  MemberList member_list;
+};
+
+struct UnionBTFTypeView final {
+  using Member = StructBTFTypeView::Member;
+  using MemberList = BTFListView<Member>;
+
+  std::optional<std::string_view> opt_name;
+  std::uint32_t size{};
+  MemberList member_list;
+};
+
+struct FwdBTFTypeView final {
+  std::string_view name;
+  bool is_union{false};
+};
+
+struct FuncBTFTypeView final {
+  std::string_view name;
+  std::uint32_t type{};
+  FuncBTFType::Linkage linkage{FuncBTFType::Linkage::Static};
+};
+
+struct FloatBTFTypeView final {
+  std::string_view name;
+  std::uint32_t size{};
+};
+
+struct VarBTFTypeView final {
+  std::string_view name;
+  std::uint32_t type{};
+  std::uint32_t linkage{};
+};
+
+struct DataSecBTFTypeView final {
+  using Variable = DataSecBTFType::Variable;
+  using VariableList = BTFListView<Variable>;
+
+  std::string_view name;
+  std::uint32_t size{};
+  VariableList variable_list;
+};
+
+// Kinds without names or lists use the same types as BTFType, and the
+// alternatives are in the same order, so that index() is the BTFKind
+using BTFTypeView =
+    std::variant<std::monostate, IntBTFTypeView, PtrBTFType, ArrayBTFType,
+                 StructBTFTypeView, UnionBTFTypeView, EnumBTFTypeView,
+                 FwdBTFTypeView, TypedefBTFTypeView, VolatileBTFType,
+                 ConstBTFType, RestrictBTFType, FuncBTFTypeView,
+                 FuncProtoBTFTypeView, VarBTFTypeView, DataSecBTFTypeView,
+                 FloatBTFTypeView>;
+
+// Called for each type found by IBTF::scan(); returning false stops the scan
+using BTFVisitor =
+    std::function<bool(std::uint32_t id, const BTFTypeView &btf_type)>;
+
+// Called for each type by IBTF::forEach(); returning false stops the
+// iteration. The type must not be retained after the callback returns
+using BTFTypeCallback =
+    std::function<bool(std::uint32_t id, const BTFType &btf_type)>;
+
 using PathList = std::vector<std::filesystem::path>;
+using BufferList = std::vector<ByteSpan>;
+
+// Identifies a split BTF file attached with IBTF::attachSplit()
+using BTFSplitHandle = std::uint32_t;
+
+struct BTFOptions final {
+  // Type sections that do not use the host byte order are converted with a
+  // single vectorized pass before being decoded, rather than swapping each
+  // field as it is read. Costs one copy of each cross-endian type section
+  bool byte_swap_type_sections{true};
+
+  // Maximum number of threads used to open and validate the input files,
+  // and to decode their type sections. One (the default) keeps all the work
+  // on the calling thread, and zero picks a value based on the number of
+  // CPUs. Threaded decoding has not been benchmarked on multi-core hosts
+  // yet, and uses more memory while loading than the serial path, since
+  // records are decoded into a temporary list before being stored
+  std::size_t thread_count{1};
+
+  // Only index the type sections when the object is created, and decode
+  // each record the first time it is accessed, together with the few
+  // records around it that share its block. Records that fail to decode
+  // at that point are reported as missing by getType() and getAll(), and as
+  // errors by getTypeOrError(), forEach() and forEachOfKind()
+  bool lazy{false};
+
+  // Skips the encoding checks while decoding, for input that has already
+  // been accepted by IBTF::validate(). Records are still bounds checked,
+  // but malformed input may be decoded into meaningless types instead of
+  // being rejected. Not used by createFromStream() and scan()
+  bool trusted{false};
+};
 
 class IBTF {
 public:
   using Ptr = std::unique_ptr<IBTF>;
 
   static Result<Ptr, BTFError>
-  createFromPath(const std::filesystem::path &path) noexcept;
+  createFromPath(const std::filesystem::path &path,
+                 const BTFOptions &options = {}) noexcept;
 
   static Result<Ptr, BTFError>
-  createFromPathList(const PathList &path_list) noexcept;
+  createFromPathList(const PathList &path_list,
+                     const BTFOptions &options = {}) noexcept;
+
+  // Parses BTF data that is already in memory, without copying it. The first
+  // buffer is the base BTF, and the ones that follow are split BTF on top of
+  // it. Borrowed buffers must outlive the returned object
+  static Result<Ptr, BTFError>
+  createFromBuffers(const BufferList &buffer_list,
+                    const BTFOptions &options = {}) noexcept;
+
+  // Same as above, but `owner` is retained for as long as the buffers are
+  // in use, allowing them to be shared with the returned object
+  static Result<Ptr, BTFError>
+  createFromBuffers(const BufferList &buffer_list,
+                    std::shared_ptr<const void> owner,
+                    const BTFOptions &options = {}) noexcept;
+
+  // Parses a single (base) BTF blob in one forward pass, using nothing but
+  // IStream::read; this works with non-seekable streams such as pipes and
+  // sockets. Type records are decoded as they arrive, and their names are
+  // resolved once the string section has been received
+  static Result<Ptr, BTFError>
+  createFromStream(IStream &stream, const BTFOptions &options = {}) noexcept;
+
+  // Decodes the given files in a single pass, without creating an IBTF
+  // object: each type is passed to the visitor as soon as it is decoded,
+  // and then discarded. Memory usage does not depend on the number of
+  // types. Returns an error if the input is invalid, in which case the
+  // visitor may have already seen the types that come before it
+  static std::optional<BTFError> scan(const PathList &path_list,
+                                      const BTFVisitor &visitor,
+                                      const BTFOptions &options = {}) noexcept;
+
+  // Checks the given files without creating an IBTF object. Every record
+  // goes through the same encoding checks as in createFromPathList(), and
+  // the type IDs it refers to must exist. Input that passes can then be
+  // loaded with BTFOptions::trusted. The type sections are checked on
+  // multiple threads, according to BTFOptions::thread_count
+  static std::optional<BTFError>
+  validate(const PathList &path_list, const BTFOptions &options = {}) noexcept;
 
   virtual std::optional<BTFType> getType(std::uint32_t id) const noexcept = 0;
   virtual std::optional<BTFKind> getKind(std::uint32_t id) const noexcept = 0;
 
+  // Same as getType(), but a record that fails to decode in lazy mode is
+  // returned as an error rather than as a missing type
+  virtual Result<std::optional<BTFType>, BTFError>
+  getTypeOrError(std::uint32_t id) const noexcept = 0;
+
+  // Returns a handle that reads the type in place; it remains valid for as
+  // long as this object. In lazy mode the type is decoded first, and the
+  // handle is empty if its record fails to decode
+  virtual BTFTypeRef getTypeRef(std::uint32_t id) const noexcept = 0;
+
   virtual std::uint32_t count() const noexcept = 0;
   virtual BTFTypeMap getAll() const noexcept = 0;
 
+  // Passes each type to the callback, in ID order, without copying them
+  // all to a map like getAll() does. Types are read in place, or put back
+  // together in buffers that are reused for the next type of the same kind
+  virtual std::optional<BTFError>
+  forEach(const BTFTypeCallback &callback) const noexcept = 0;
+
+  // Same as above, but only for the types of the given kind. The IDs of
+  // each kind are listed by the first call, so the types of the other kinds
+  // are not visited
+  virtual std::optional<BTFError>
+  forEachOfKind(BTFKind kind,
+                const BTFTypeCallback &callback) const noexcept = 0;
+
+  // Parses a split BTF file (such as a kernel module) on top of the base
+  // this object was created from, which is neither parsed nor decoded
+  // again. The base is the first file only: split files that were passed
+  // when the object was created are not visible to the attached ones.
+  // Every attached file starts from the same base type ID, so its types
+  // are accessed through the returned handle, and their names remain
+  // valid until detach() is called
+  virtual Result<BTFSplitHandle, BTFError>
+  attachSplit(const std::filesystem::path &path) noexcept = 0;
+
+  // Releases a split BTF file; returns false if the handle is not valid
+  virtual bool detach(BTFSplitHandle handle) noexcept = 0;
+
+  // Type IDs that belong to the base are forwarded to getType(id), and the
+  // other ones are only looked up in the split file
+  virtual std::optional<BTFType> getType(BTFSplitHandle handle,
+                                         std::uint32_t id) const noexcept = 0;
+
+  // Same as above, for getTypeRef(id). Handles to the types of the split
+  // file remain valid until detach() is called
+  virtual BTFTypeRef getTypeRef(BTFSplitHandle handle,
+                                std::uint32_t id) const noexcept = 0;
+
+  // Only returns the types defined by the split BTF file
+  virtual BTFTypeMap getAll(BTFSplitHandle handle) const noexcept = 0;
+
   static BTFKind getBTFTypeKind(const BTFType &btf_type) noexcept;
 
   IBTF() = default;
@@ -7,159 +7,943 @@
 //
 
 #include "btf.h"
-
+#include "btftypedecoder.h"
+#include "byteswap.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <mutex>
 #include <unordered_map>
 
 namespace btfparse {
 
 namespace {
 
-const std::unordered_map<BTFKind, BTFTypeParser> kBTFParserMap{
-    {BTFKind::Int, BTF::parseIntData},
-    {BTFKind::Ptr, BTF::parsePtrData},
-    {BTFKind::Const, BTF::parseConstData},
-    {BTFKind::Array, BTF::parseArrayData},
-    {BTFKind::Typedef, BTF::parseTypedefData},
-    {BTFKind::Enum, BTF::parseEnumData},
-    {BTFKind::FuncProto, BTF::parseFuncProtoData},
-    {BTFKind::Volatile, BTF::parseVolatileData},
-    {BTFKind::Struct, BTF::parseStructData},
-    {BTFKind::Union, BTF::parseUnionData},
-    {BTFKind::Fwd, BTF::parseFwdData},
-    {BTFKind::Func, BTF::parseFuncData},
-    {BTFKind::Float, BTF::parseFloatData},
-    {BTFKind::Restrict, BTF::parseRestrictData},
-    {BTFKind::Var, BTF::parseVarData},
-    {BTFKind::DataSec, BTF::parseDataSecData}};
-
-template <typename Type>
-std::optional<BTFError>
-parseStructOrUnionData(Type &output, const BTFFileList &btf_file_list,
-                       const BTFTypeHeader &btf_type_header,
-                       IFileReader &file_reader) noexcept {
+const std::size_t kStreamChunkSize{64U * 1024U};
 
-  static_assert(std::is_same<Type, StructBTFType>::value ||
-                    std::is_same<Type, UnionBTFType>::value,
-                "Type must be either StructBTFType or UnionBTFType");
+// Number of consecutive records decoded by a single task when type
+// sections are parsed in parallel
+const std::size_t kParallelDecodeChunkSize{4096U};
 
-  try {
-    output = {};
+// Number of consecutive records decoded together in lazy mode
+const std::uint32_t kLazyTypeBlockSize{16U};
+
+// Calls `callback` with a cursor over `data` that is specialized for the
+// byte order and the trust level of the given type section
+template <typename Callback>
+auto withTypeSectionCursor(const BTFTypeSection &type_section, ByteSpan data,
+                           std::uint64_t file_offset, Callback callback) {
+  if (type_section.endianness == Endianness::Little) {
+    if (type_section.trusted) {
+      BTFCursor<Endianness::Little, true> cursor(data, file_offset);
+      return callback(cursor);
+    }
 
-    output.size = btf_type_header.size_or_type;
+    BTFCursor<Endianness::Little> cursor(data, file_offset);
+    return callback(cursor);
+  }
 
-    if (btf_type_header.name_off != 0) {
-      auto name_res = BTF::parseString(btf_file_list, btf_type_header.name_off);
-      if (name_res.failed()) {
-        return name_res.takeError();
-      }
+  if (type_section.trusted) {
+    BTFCursor<Endianness::Big, true> cursor(data, file_offset);
+    return callback(cursor);
+  }
 
-      output.opt_name = name_res.takeValue();
+  BTFCursor<Endianness::Big> cursor(data, file_offset);
+  return callback(cursor);
+}
+
+// Reads a stream front to back, keeping track of the absolute offset so
+// that it can be used in the error information
+class SequentialStreamReader final {
+  IStream &stream;
+  std::uint64_t stream_offset{0};
+
+public:
+  SequentialStreamReader(IStream &stream_) : stream(stream_) {}
+
+  std::uint64_t offset() const { return stream_offset; }
+
+  void read(std::uint8_t *buffer, std::size_t size) {
+    if (!stream.read(buffer, size)) {
+      throw FileReaderError(
+          {FileReaderErrorInformation::Code::IOError,
+           FileReaderErrorInformation::ReadOperation{stream_offset, size}});
     }
 
-    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
-      typename Type::Member member{};
+    stream_offset += size;
+  }
+
+  void skipTo(std::uint64_t offset) {
+    if (offset < stream_offset) {
+      throw FileReaderError(
+          {FileReaderErrorInformation::Code::IOError,
+           FileReaderErrorInformation::ReadOperation{offset, 0}});
+    }
+
+    std::array<std::uint8_t, 256> discard_buffer;
+
+    while (stream_offset < offset) {
+      auto size = static_cast<std::size_t>(std::min<std::uint64_t>(
+          discard_buffer.size(), offset - stream_offset));
+
+      read(discard_buffer.data(), size);
+    }
+  }
+};
+
+// Decodes a type section as it is read from the stream. Only the records
+// that have been fully received are handed to the parser, and the buffer
+// only grows past kStreamChunkSize for records that are larger than that
+template <Endianness endianness>
+std::optional<BTFError>
+parseStreamedTypeSection(BTFTypeStore &btf_type_store,
+                         const BTFFileList &btf_file_list,
+                         SequentialStreamReader &reader,
+                         std::uint64_t type_section_size) {
+
+  std::uint32_t type_id{1U};
+
+  std::vector<std::uint8_t> buffer;
+  std::size_t buffer_size{0};
+  auto buffer_offset = reader.offset();
+
+  for (auto remaining_size = type_section_size;
+       remaining_size != 0 || buffer_size != 0;) {
+
+    auto read_size = static_cast<std::size_t>(
+        std::min<std::uint64_t>(remaining_size, kStreamChunkSize));
 
-      auto member_name_off = file_reader.u32();
-      if (member_name_off != 0) {
-        auto member_name_res = BTF::parseString(btf_file_list, member_name_off);
-        if (member_name_res.failed()) {
-          return member_name_res.takeError();
+    buffer.resize(std::max(buffer.size(), buffer_size + read_size));
+    reader.read(buffer.data() + buffer_size, read_size);
+
+    buffer_size += read_size;
+    remaining_size -= read_size;
+
+    std::size_t complete_size{0};
+
+    if (remaining_size == 0) {
+      // Truncated records at the end of the section are left for the
+      // parser to report
+      complete_size = buffer_size;
+
+    } else {
+      while (buffer_size - complete_size >= kBTFTypeHeaderSize) {
+        BTFCursor<endianness> header_cursor(
+            ByteSpan(buffer.data() + complete_size, kBTFTypeHeaderSize),
+            buffer_offset + complete_size);
+
+        auto btf_type_header_res = BTF::parseTypeHeader(header_cursor);
+        if (btf_type_header_res.failed()) {
+          return btf_type_header_res.takeError();
         }
 
-        member.opt_name = member_name_res.takeValue();
-      }
+        auto opt_data_size =
+            BTF::getTypeDataSize(btf_type_header_res.takeValue());
 
-      member.type = file_reader.u32();
+        if (!opt_data_size.has_value()) {
+          complete_size = buffer_size;
+          break;
+        }
 
-      auto offset = file_reader.u32();
-      if (btf_type_header.kind_flag) {
-        member.offset = offset & 0xFFFFFFUL;
-        member.opt_bitfield_size = static_cast<std::uint8_t>(offset >> 24);
+        auto record_size = kBTFTypeHeaderSize + opt_data_size.value();
+        if (buffer_size - complete_size < record_size) {
+          break;
+        }
 
-      } else {
-        member.offset = offset;
+        complete_size += record_size;
       }
+    }
 
-      output.member_list.push_back(std::move(member));
+    if (complete_size == 0) {
+      continue;
     }
 
-    return std::nullopt;
+    BTFCursor<endianness> cursor(ByteSpan(buffer.data(), complete_size),
+                                 buffer_offset);
 
-  } catch (const FileReaderError &error) {
-    return BTF::convertFileReaderError(error);
+    auto opt_error =
+        BTF::parseTypeSection(btf_type_store, type_id, btf_file_list, cursor);
+
+    if (opt_error.has_value()) {
+      return opt_error;
+    }
+
+    std::memmove(buffer.data(), buffer.data() + complete_size,
+                 buffer_size - complete_size);
+
+    buffer_size -= complete_size;
+    buffer_offset += complete_size;
   }
+
+  return std::nullopt;
+}
+
+std::optional<BTFError> resolveDeferredString(std::string_view &name,
+                                              ByteSpan string_section) {
+  auto offset = static_cast<std::size_t>(
+      reinterpret_cast<const std::uint8_t *>(name.data()) -
+      string_section.data());
+
+  const void *terminator{nullptr};
+  if (offset < string_section.size()) {
+    terminator = std::memchr(string_section.data() + offset, 0,
+                             string_section.size() - offset);
+  }
+
+  if (terminator == nullptr) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::InvalidStringOffset,
+            btfparse::BTFErrorInformation::FileRange{offset, 0},
+        },
+    };
+  }
+
+  auto string_start =
+      reinterpret_cast<const char *>(string_section.data() + offset);
+
+  name = std::string_view(
+      string_start,
+      static_cast<std::size_t>(static_cast<const char *>(terminator) -
+                               string_start));
+
+  return std::nullopt;
+}
+
+std::optional<BTFError>
+resolveDeferredString(std::optional<std::string_view> &opt_name,
+                      ByteSpan string_section) {
+  if (!opt_name.has_value()) {
+    return std::nullopt;
+  }
+
+  return resolveDeferredString(opt_name.value(), string_section);
 }
 
 } // namespace
 
 struct BTF::PrivateData final {
-  BTFTypeMap btf_type_map;
+  BTFTypeTable btf_type_table;
+
+  // Streams only: the string section that the type names point inside
+  std::vector<std::uint8_t> string_section;
+
+  // The inputs are retained so that split BTF files can be attached later
+  BTFOptions options;
+  BTFFileList btf_file_list;
+
+  // Lazy mode only: records are decoded on first access, one block of
+  // kLazyTypeBlockSize IDs at a time
+  bool lazy{false};
+  BTFTypeSectionList type_section_list;
+  BTFTypeIndex type_index;
+  BTFLazyTypeBlockList lazy_type_block_list;
+  std::mutex lazy_type_block_list_mutex;
+
+  // Created by the first forEachOfKind() call
+  BTFKindIndex kind_index;
+  std::once_flag kind_index_flag;
+
+  std::unordered_map<BTFSplitHandle, BTFSplit> btf_split_map;
+  BTFSplitHandle next_split_handle{1U};
+  std::mutex btf_split_map_mutex;
+
+  // The number of types in the first file, which attached split files are
+  // built on; counted by the first attachSplit() call
+  std::optional<std::uint32_t> opt_base_type_count;
+  std::mutex base_type_count_mutex;
 };
 
 BTF::~BTF() {}
 
 std::optional<BTFType> BTF::getType(std::uint32_t id) const noexcept {
-  auto btf_type_map_it = d->btf_type_map.find(id);
-  if (btf_type_map_it == d->btf_type_map.end()) {
+  auto opt_btf_type_res = getTypeOrError(id);
+  if (opt_btf_type_res.failed()) {
     return std::nullopt;
   }
 
-  return btf_type_map_it->second;
+  return opt_btf_type_res.takeValue();
+}
+
+Result<std::optional<BTFType>, BTFError>
+BTF::getTypeOrError(std::uint32_t id) const noexcept {
+  if (!d->lazy) {
+    return d->btf_type_table.get(id);
+  }
+
+  if (id == 0 || id > d->type_index.size()) {
+    return std::optional<BTFType>();
+  }
+
+  auto lazy_type_block_res = getLazyTypeBlock(id);
+  if (lazy_type_block_res.failed()) {
+    return lazy_type_block_res.takeError();
+  }
+
+  const auto &lazy_type_block = *lazy_type_block_res.takeValue();
+
+  const auto &opt_error =
+      lazy_type_block.error_list[(id - 1U) % kLazyTypeBlockSize];
+
+  if (opt_error.has_value()) {
+    return opt_error.value();
+  }
+
+  return lazy_type_block.btf_type_table.get(id);
 }
 
 std::optional<BTFKind> BTF::getKind(std::uint32_t id) const noexcept {
-  auto btf_type_map_it = d->btf_type_map.find(id);
-  if (btf_type_map_it == d->btf_type_map.end()) {
-    return std::nullopt;
+  if (d->lazy) {
+    if (id == 0 || id > d->type_index.size()) {
+      return std::nullopt;
+    }
+
+    return d->type_index[id - 1].kind;
+  }
+
+  return d->btf_type_table.getKind(id);
+}
+
+BTFTypeRef BTF::getTypeRef(std::uint32_t id) const noexcept {
+  if (!d->lazy) {
+    if (!d->btf_type_table.contains(id)) {
+      return {};
+    }
+
+    return BTFTypeRef(&d->btf_type_table, id);
   }
 
-  const auto &btf_type = btf_type_map_it->second;
-  return getBTFTypeKind(btf_type);
+  if (id == 0 || id > d->type_index.size()) {
+    return {};
+  }
+
+  auto lazy_type_block_res = getLazyTypeBlock(id);
+  if (lazy_type_block_res.failed()) {
+    return {};
+  }
+
+  const auto &btf_type_table = lazy_type_block_res.takeValue()->btf_type_table;
+  if (!btf_type_table.contains(id)) {
+    return {};
+  }
+
+  return BTFTypeRef(&btf_type_table, id);
 }
 
 std::uint32_t BTF::count() const noexcept {
-  return static_cast<std::uint32_t>(d->btf_type_map.size());
+  if (d->lazy) {
+    return static_cast<std::uint32_t>(d->type_index.size());
+  }
+
+  return d->btf_type_table.size();
 }
 
-BTFTypeMap BTF::getAll() const noexcept { return d->btf_type_map; }
+BTFTypeMap BTF::getAll() const noexcept {
+  if (!d->lazy) {
+    return d->btf_type_table.toMap();
+  }
 
-BTF::BTF(const PathList &path_list) : d(new PrivateData) {
-  BTFFileList btf_file_list;
+  BTFTypeMap btf_type_map;
 
-  for (const auto &path : path_list) {
-    auto file_reader_res = IFileReader::open(path);
-    if (file_reader_res.failed()) {
-      throw convertFileReaderError(file_reader_res.takeError());
+  for (std::uint32_t id = 1; id <= d->type_index.size(); ++id) {
+    auto opt_btf_type = getType(id);
+    if (opt_btf_type.has_value()) {
+      btf_type_map.insert({id, std::move(opt_btf_type.value())});
     }
+  }
 
-    BTFFile btf_file;
-    btf_file.file_reader = file_reader_res.takeValue();
+  return btf_type_map;
+}
 
-    auto &file_reader = *btf_file.file_reader.get();
+std::optional<BTFError>
+BTF::forEach(const BTFTypeCallback &callback) const noexcept {
+  auto end_id = d->lazy ? count() + 1U : d->btf_type_table.endId();
+
+  try {
+    BTFTypeTable::AssemblyBuffer buffer;
+
+    for (std::uint32_t id = 1; id < end_id; ++id) {
+      auto visit_res = visitType(id, buffer, callback);
+      if (visit_res.failed()) {
+        return visit_res.takeError();
+      }
+
+      if (!visit_res.takeValue()) {
+        break;
+      }
+    }
+
+  } catch (const std::bad_alloc &) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::MemoryAllocationFailure,
+        },
+    };
+  }
+
+  return std::nullopt;
+}
+
+std::optional<BTFError>
+BTF::forEachOfKind(BTFKind kind,
+                   const BTFTypeCallback &callback) const noexcept {
+  auto kind_index = static_cast<std::size_t>(kind);
+  if (kind_index >= d->kind_index.size()) {
+    return std::nullopt;
+  }
+
+  try {
+    std::call_once(d->kind_index_flag,
+                   [this]() { d->kind_index = indexKinds(*this); });
+
+    BTFTypeTable::AssemblyBuffer buffer;
+
+    for (auto id : d->kind_index[kind_index]) {
+      auto visit_res = visitType(id, buffer, callback);
+      if (visit_res.failed()) {
+        return visit_res.takeError();
+      }
+
+      if (!visit_res.takeValue()) {
+        break;
+      }
+    }
+
+  } catch (const std::bad_alloc &) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::MemoryAllocationFailure,
+        },
+    };
+  }
+
+  return std::nullopt;
+}
+
+Result<BTFSplitHandle, BTFError>
+BTF::attachSplit(const std::filesystem::path &path) noexcept {
+  if (d->btf_file_list.empty()) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::BaseBTFNotAvailable,
+        },
+    };
+  }
+
+  try {
+    auto btf_file_list_res = openPathList({path}, d->options);
+    if (btf_file_list_res.failed()) {
+      return btf_file_list_res.takeError();
+    }
+
+    // Split files are attached to the base alone, even if this object was
+    // created with split files of its own
+    auto base_type_count_res = getBaseTypeCount();
+    if (base_type_count_res.failed()) {
+      return base_type_count_res.takeError();
+    }
+
+    BTFSplit btf_split;
+    btf_split.btf_file_list.push_back(d->btf_file_list.front());
+    btf_split.btf_file_list.push_back(
+        std::move(btf_file_list_res.takeValue().front()));
+
+    indexStringSections(btf_split.btf_file_list);
+
+    // Only the records of the split file are decoded; its type IDs follow
+    // the ones of the base
+    auto btf_type_table_res =
+        parseSplitTypeSection(btf_split.btf_file_list,
+                              base_type_count_res.takeValue() + 1, d->options);
+
+    if (btf_type_table_res.failed()) {
+      return btf_type_table_res.takeError();
+    }
+
+    btf_split.btf_type_table = btf_type_table_res.takeValue();
+
+    std::lock_guard<std::mutex> lock(d->btf_split_map_mutex);
+
+    auto handle = d->next_split_handle++;
+    d->btf_split_map.insert({handle, std::move(btf_split)});
+
+    return handle;
+
+  } catch (const std::bad_alloc &) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::MemoryAllocationFailure,
+        },
+    };
+  }
+}
+
+bool BTF::detach(BTFSplitHandle handle) noexcept {
+  std::lock_guard<std::mutex> lock(d->btf_split_map_mutex);
+  return d->btf_split_map.erase(handle) != 0;
+}
+
+std::optional<BTFType> BTF::getType(BTFSplitHandle handle,
+                                    std::uint32_t id) const noexcept {
+  {
+    std::lock_guard<std::mutex> lock(d->btf_split_map_mutex);
+
+    auto btf_split_map_it = d->btf_split_map.find(handle);
+    if (btf_split_map_it == d->btf_split_map.end()) {
+      return std::nullopt;
+    }
+
+    // The IDs that follow the base belong to the split file alone
+    const auto &btf_type_table = btf_split_map_it->second.btf_type_table;
+    if (id >= btf_type_table.firstId()) {
+      return btf_type_table.get(id);
+    }
+  }
+
+  return getType(id);
+}
+
+BTFTypeRef BTF::getTypeRef(BTFSplitHandle handle,
+                           std::uint32_t id) const noexcept {
+  {
+    std::lock_guard<std::mutex> lock(d->btf_split_map_mutex);
+
+    auto btf_split_map_it = d->btf_split_map.find(handle);
+    if (btf_split_map_it == d->btf_split_map.end()) {
+      return {};
+    }
+
+    // Splits are never moved once attached, so the handle remains valid
+    // until detach()
+    const auto &btf_type_table = btf_split_map_it->second.btf_type_table;
+    if (id >= btf_type_table.firstId()) {
+      if (!btf_type_table.contains(id)) {
+        return {};
+      }
+
+      return BTFTypeRef(&btf_type_table, id);
+    }
+  }
+
+  return getTypeRef(id);
+}
+
+BTFTypeMap BTF::getAll(BTFSplitHandle handle) const noexcept {
+  std::lock_guard<std::mutex> lock(d->btf_split_map_mutex);
+
+  auto btf_split_map_it = d->btf_split_map.find(handle);
+  if (btf_split_map_it == d->btf_split_map.end()) {
+    return {};
+  }
+
+  return btf_split_map_it->second.btf_type_table.toMap();
+}
+
+BTF::BTF(BTFFileList btf_file_list, const BTFOptions &options)
+    : d(new PrivateData) {
+  d->options = options;
+
+  if (!options.lazy) {
+    auto btf_type_table_res = parseTypeSections(btf_file_list, options);
+    if (btf_type_table_res.failed()) {
+      throw btf_type_table_res.takeError();
+    }
+
+    d->btf_type_table = btf_type_table_res.takeValue();
+    d->btf_file_list = std::move(btf_file_list);
+    return;
+  }
+
+  auto type_section_list_res = loadTypeSections(btf_file_list, options);
+  if (type_section_list_res.failed()) {
+    throw type_section_list_res.takeError();
+  }
+
+  d->type_section_list = type_section_list_res.takeValue();
+
+  auto type_index_res = indexTypeSections(d->type_section_list, options);
+  if (type_index_res.failed()) {
+    // A copy rather than takeError(): GCC 12 reports a spurious
+    // -Wfree-nonheap-object for the latter in this constructor
+    throw type_index_res.error();
+  }
+
+  d->type_index = type_index_res.takeValue();
+  d->btf_file_list = std::move(btf_file_list);
+  d->lazy = true;
+
+  auto lazy_type_block_count =
+      (d->type_index.size() + kLazyTypeBlockSize - 1U) / kLazyTypeBlockSize;
+
+  d->lazy_type_block_list.resize(lazy_type_block_count);
+}
+
+BTF::BTF(BTFTypeStore btf_type_store, std::vector<std::uint8_t> string_section)
+    : d(new PrivateData) {
+  d->btf_type_table = BTFTypeTable(std::move(btf_type_store));
+  d->string_section = std::move(string_section);
+}
+
+Result<bool, BTFError>
+BTF::visitType(std::uint32_t id, BTFTypeTable::AssemblyBuffer &buffer,
+               const BTFTypeCallback &callback) const {
+  const auto *btf_type_table = &d->btf_type_table;
+
+  if (d->lazy) {
+    auto lazy_type_block_res = getLazyTypeBlock(id);
+    if (lazy_type_block_res.failed()) {
+      return lazy_type_block_res.takeError();
+    }
+
+    const auto &lazy_type_block = *lazy_type_block_res.takeValue();
+
+    const auto &opt_error =
+        lazy_type_block.error_list[(id - 1U) % kLazyTypeBlockSize];
 
-    bool little_endian{false};
-    auto opt_error = detectEndianness(little_endian, file_reader);
     if (opt_error.has_value()) {
-      throw opt_error.value();
+      return opt_error.value();
+    }
+
+    btf_type_table = &lazy_type_block.btf_type_table;
+  }
+
+  auto btf_type = btf_type_table->assemble(id, buffer);
+  return btf_type == nullptr || callback(id, *btf_type);
+}
+
+Result<const BTFLazyTypeBlock *, BTFError>
+BTF::getLazyTypeBlock(std::uint32_t id) const noexcept {
+  auto block_index = (id - 1U) / kLazyTypeBlockSize;
+
+  {
+    std::lock_guard<std::mutex> lock(d->lazy_type_block_list_mutex);
+
+    const auto &lazy_type_block = d->lazy_type_block_list[block_index];
+    if (lazy_type_block != nullptr) {
+      return lazy_type_block.get();
     }
+  }
+
+  // Decoding only reads immutable data, so it happens outside of the lock
+  try {
+    auto first_id = block_index * kLazyTypeBlockSize + 1U;
+    auto end_id = std::min(first_id + kLazyTypeBlockSize,
+                           static_cast<std::uint32_t>(d->type_index.size()) +
+                               1U);
+
+    auto lazy_type_block = std::make_unique<BTFLazyTypeBlock>();
+    lazy_type_block->error_list.resize(end_id - first_id);
+
+    std::vector<BTFType> btf_type_list;
+    btf_type_list.reserve(end_id - first_id);
+
+    for (auto type_id = first_id; type_id < end_id; ++type_id) {
+      const auto &type_location = d->type_index[type_id - 1U];
+
+      auto btf_type_res =
+          parseTypeAt(d->btf_file_list,
+                      d->type_section_list[type_location.section_index],
+                      type_location.offset);
+
+      if (btf_type_res.failed()) {
+        lazy_type_block->error_list[type_id - first_id] =
+            btf_type_res.takeError();
 
-    file_reader.setEndianness(little_endian);
+        btf_type_list.emplace_back();
 
-    auto btf_header_res = readBTFHeader(file_reader);
-    if (btf_header_res.failed()) {
-      throw btf_header_res.takeError();
+      } else {
+        btf_type_list.push_back(btf_type_res.takeValue());
+      }
     }
 
-    btf_file.btf_header = btf_header_res.takeValue();
-    btf_file_list.push_back(std::move(btf_file));
+    lazy_type_block->btf_type_table =
+        BTFTypeTable(first_id, std::move(btf_type_list));
+
+    std::lock_guard<std::mutex> lock(d->lazy_type_block_list_mutex);
+
+    // Another thread may have decoded the same block in the meantime
+    auto &published_block = d->lazy_type_block_list[block_index];
+    if (published_block == nullptr) {
+      published_block = std::move(lazy_type_block);
+    }
+
+    return published_block.get();
+
+  } catch (const std::bad_alloc &) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::MemoryAllocationFailure,
+        },
+    };
   }
+}
 
-  auto btf_type_map_res = parseTypeSections(btf_file_list);
-  if (btf_type_map_res.failed()) {
-    throw btf_type_map_res.takeError();
+Result<std::uint32_t, BTFError> BTF::getBaseTypeCount() {
+  if (d->btf_file_list.size() == 1) {
+    return count();
   }
 
-  d->btf_type_map = btf_type_map_res.takeValue();
+  std::lock_guard<std::mutex> lock(d->base_type_count_mutex);
+
+  if (d->opt_base_type_count.has_value()) {
+    return d->opt_base_type_count.value();
+  }
+
+  std::uint32_t base_type_count{};
+
+  if (d->lazy) {
+    // The index lists the records of each file in order
+    for (const auto &type_location : d->type_index) {
+      if (type_location.section_index != 0) {
+        break;
+      }
+
+      ++base_type_count;
+    }
+
+  } else {
+    // Only the record headers of the base are read
+    auto type_section_res =
+        loadTypeSection(d->btf_file_list.front(), d->options);
+
+    if (type_section_res.failed()) {
+      return type_section_res.takeError();
+    }
+
+    BTFTypeSectionList type_section_list;
+    type_section_list.push_back(type_section_res.takeValue());
+
+    auto type_index_res = indexTypeSections(type_section_list, d->options);
+    if (type_index_res.failed()) {
+      return type_index_res.takeError();
+    }
+
+    base_type_count =
+        static_cast<std::uint32_t>(type_index_res.takeValue().size());
+  }
+
+  d->opt_base_type_count = base_type_count;
+  return base_type_count;
+}
+
+Result<IBTF::Ptr, BTFError> BTF::create(BTFFileList btf_file_list,
+                                        const BTFOptions &options) noexcept {
+  try {
+    return Ptr(new BTF(std::move(btf_file_list), options));
+
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+
+  } catch (const BTFError &e) {
+    return e;
+  }
+}
+
+Result<IBTF::Ptr, BTFError> BTF::createFromStream(IStream &stream) noexcept {
+  std::vector<std::uint8_t> string_section;
+
+  auto btf_type_store_res = parseStream(string_section, stream);
+  if (btf_type_store_res.failed()) {
+    return btf_type_store_res.takeError();
+  }
+
+  try {
+    return Ptr(
+        new BTF(btf_type_store_res.takeValue(), std::move(string_section)));
+
+  } catch (const std::bad_alloc &) {
+    return BTFError(BTFErrorInformation{
+        BTFErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+Result<BTFFileList, BTFError>
+BTF::openPathList(const PathList &path_list,
+                  const BTFOptions &options) noexcept {
+  try {
+    // Each file is opened, mapped and validated independently, so the
+    // paths are spread across a small pool of threads. Results are stored
+    // by index to keep the caller's order (base BTF first)
+    BTFFileList btf_file_list(path_list.size());
+    std::vector<std::optional<BTFError>> opt_error_list(path_list.size());
+
+    auto thread_count =
+        ThreadPool::getThreadCount(options.thread_count, path_list.size());
+
+    ThreadPool::forEachIndex(
+        path_list.size(), thread_count, [&](std::size_t index) {
+          auto file_reader_res = IFileReader::open(path_list[index]);
+          if (file_reader_res.failed()) {
+            opt_error_list[index] =
+                convertFileReaderError(file_reader_res.takeError());
+
+            return;
+          }
+
+          auto btf_file_res = openBTFFile(file_reader_res.takeValue());
+          if (btf_file_res.failed()) {
+            opt_error_list[index] = btf_file_res.takeError();
+            return;
+          }
+
+          btf_file_list[index] = btf_file_res.takeValue();
+        });
+
+    for (auto &opt_error : opt_error_list) {
+      if (opt_error.has_value()) {
+        return opt_error.value();
+      }
+    }
+
+    indexStringSections(btf_file_list);
+    return btf_file_list;
+
+  } catch (const std::bad_alloc &) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::MemoryAllocationFailure,
+        },
+    };
+  }
+}
+
+Result<BTFFileList, BTFError>
+BTF::openBufferList(const BufferList &buffer_list,
+                    const std::shared_ptr<const void> &owner) noexcept {
+  try {
+    BTFFileList btf_file_list;
+
+    for (const auto &buffer : buffer_list) {
+      auto file_reader_res = IFileReader::createFromBuffer(buffer, owner);
+      if (file_reader_res.failed()) {
+        return convertFileReaderError(file_reader_res.takeError());
+      }
+
+      auto btf_file_res = openBTFFile(file_reader_res.takeValue());
+      if (btf_file_res.failed()) {
+        return btf_file_res.takeError();
+      }
+
+      btf_file_list.push_back(btf_file_res.takeValue());
+    }
+
+    indexStringSections(btf_file_list);
+    return btf_file_list;
+
+  } catch (const std::bad_alloc &) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::MemoryAllocationFailure,
+        },
+    };
+  }
+}
+
+Result<BTFFile, BTFError>
+BTF::openBTFFile(IFileReader::Ptr file_reader) noexcept {
+  BTFFile btf_file;
+  btf_file.file_reader = std::move(file_reader);
+
+  auto &file_reader_ref = *btf_file.file_reader.get();
+
+  bool little_endian{false};
+  auto opt_error = detectEndianness(little_endian, file_reader_ref);
+  if (opt_error.has_value()) {
+    return opt_error.value();
+  }
+
+  file_reader_ref.setEndianness(little_endian);
+  btf_file.little_endian = little_endian;
+
+  auto btf_header_res = readBTFHeader(file_reader_ref);
+  if (btf_header_res.failed()) {
+    return btf_header_res.takeError();
+  }
+
+  btf_file.btf_header = btf_header_res.takeValue();
+
+  // Type names point inside the string section, so it has to stay
+  // available for as long as the file is open
+  auto string_section_offset =
+      static_cast<std::uint64_t>(btf_file.btf_header.hdr_len) +
+      btf_file.btf_header.str_off;
+
+  auto opt_string_section = file_reader_ref.view(string_section_offset,
+                                                 btf_file.btf_header.str_len);
+
+  if (opt_string_section.has_value()) {
+    btf_file.string_section = opt_string_section.value();
+    return btf_file;
+  }
+
+  try {
+    auto string_buffer = std::make_shared<std::vector<std::uint8_t>>(
+        btf_file.btf_header.str_len);
+
+    file_reader_ref.readAt(string_section_offset, string_buffer->data(),
+                           string_buffer->size());
+
+    btf_file.string_section =
+        ByteSpan(string_buffer->data(), string_buffer->size());
+
+    btf_file.string_buffer = std::move(string_buffer);
+
+  } catch (const std::bad_alloc &) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::MemoryAllocationFailure,
+        },
+    };
+
+  } catch (const FileReaderError &error) {
+    return convertFileReaderError(error);
+  }
+
+  return btf_file;
+}
+
+void BTF::indexStringSections(BTFFileList &btf_file_list) noexcept {
+  // Each split file appends its strings to the ones of the files that come
+  // before it
+  std::uint32_t string_offset{};
+
+  for (auto &btf_file : btf_file_list) {
+    btf_file.string_offset = string_offset;
+    string_offset += btf_file.btf_header.str_len;
+  }
+}
+
+BTFKindIndex BTF::indexKinds(const IBTF &btf) {
+  // The IDs are counted first, so that each list is allocated once
+  std::array<std::size_t, std::tuple_size_v<BTFKindIndex>> id_count_list{};
+
+  auto type_count = btf.count();
+  for (std::uint32_t id = 1; id <= type_count; ++id) {
+    auto opt_kind = btf.getKind(id);
+    if (opt_kind.has_value()) {
+      ++id_count_list[static_cast<std::size_t>(opt_kind.value())];
+    }
+  }
+
+  BTFKindIndex kind_index;
+  for (std::size_t i = 0; i < kind_index.size(); ++i) {
+    kind_index[i].reserve(id_count_list[i]);
+  }
+
+  for (std::uint32_t id = 1; id <= type_count; ++id) {
+    auto opt_kind = btf.getKind(id);
+    if (opt_kind.has_value()) {
+      kind_index[static_cast<std::size_t>(opt_kind.value())].push_back(id);
+    }
+  }
+
+  return kind_index;
 }
 
 BTFError BTF::convertFileReaderError(const FileReaderError &error) noexcept {
@@ -182,6 +966,22 @@ BTFError BTF::convertFileReaderError(const FileReaderError &error) noexcept {
   case FileReaderErrorInformation::Code::IOError:
     error_code = BTFErrorInformation::Code::IOError;
     break;
+
+  case FileReaderErrorInformation::Code::InvalidELFImage:
+    error_code = BTFErrorInformation::Code::InvalidELFImage;
+    break;
+
+  case FileReaderErrorInformation::Code::SectionNotFound:
+    error_code = BTFErrorInformation::Code::SectionNotFound;
+    break;
+
+  case FileReaderErrorInformation::Code::UnsupportedCompressionFormat:
+    error_code = BTFErrorInformation::Code::UnsupportedCompressionFormat;
+    break;
+
+  case FileReaderErrorInformation::Code::DecompressionError:
+    error_code = BTFErrorInformation::Code::DecompressionError;
+    break;
   }
 
   std::optional<BTFErrorInformation::FileRange> opt_file_range;
@@ -253,781 +1053,958 @@ BTF::readBTFHeader(IFileReader &file_reader) noexcept {
   }
 }
 
-Result<BTFTypeMap, BTFError>
-BTF::parseTypeSections(const BTFFileList &btf_file_list) noexcept {
-  BTFTypeMap btf_type_map;
-
-  std::uint32_t type_id{1U};
-
-  try {
-    for (auto &btf_file : btf_file_list) {
-      const auto &btf_header = btf_file.btf_header;
-      auto &file_reader = *btf_file.file_reader.get();
-
-      auto type_section_start_offset = btf_header.hdr_len + btf_header.type_off;
-      auto type_section_end_offset =
-          type_section_start_offset + btf_header.type_len;
-
-      file_reader.seek(type_section_start_offset);
-
-      for (;;) {
-        auto current_offset = file_reader.offset();
-        if (current_offset >= type_section_end_offset) {
-          break;
-        }
-
-        auto btf_type_header_res = parseTypeHeader(file_reader);
-        if (btf_type_header_res.failed()) {
-          return btf_type_header_res.takeError();
-        }
-
-        auto btf_type_header = btf_type_header_res.takeValue();
-
-        BTFErrorInformation::FileRange file_range{current_offset,
-                                                  kBTFTypeHeaderSize};
-
-        if (btf_type_header.kind > static_cast<std::uint8_t>(BTFKind::Float)) {
-          return BTFError{
-              BTFErrorInformation{BTFErrorInformation::Code::InvalidBTFKind,
-                                  file_range},
-          };
-        }
-
-        auto btf_kind = static_cast<BTFKind>(btf_type_header.kind);
-
-        auto parser_it = kBTFParserMap.find(btf_kind);
-        if (parser_it == kBTFParserMap.end()) {
-          return BTFError{
-              BTFErrorInformation{BTFErrorInformation::Code::UnsupportedBTFKind,
-                                  file_range},
-          };
-        }
-
-        const auto &parser = parser_it->second;
-
-        auto btf_type_res = parser(btf_file_list, btf_type_header, file_reader);
-        if (btf_type_res.failed()) {
-          return btf_type_res.takeError();
-        }
-
-        btf_type_map.insert({type_id, btf_type_res.takeValue()});
-        ++type_id;
+Result<BTFTypeTable, BTFError>
+BTF::parseTypeSections(const BTFFileList &btf_file_list,
+                       const BTFOptions &options) noexcept {
+  auto thread_count = ThreadPool::getThreadCount(
+      options.thread_count, std::numeric_limits<std::size_t>::max());
+
+  if (thread_count > 1) {
+    // The boundary scan only reads the record headers, and gives each
+    // record its type ID. If it fails, the serial path is used instead, as
+    // it is the one that picks which error gets reported
+    auto type_section_list_res = loadTypeSections(btf_file_list, options);
+
+    if (!type_section_list_res.failed()) {
+      auto type_section_list = type_section_list_res.takeValue();
+
+      auto type_index_res = indexTypeSections(type_section_list, options);
+      if (!type_index_res.failed()) {
+        return decodeTypeSections(btf_file_list, type_section_list,
+                                  type_index_res.takeValue(), options);
       }
     }
-
-    return btf_type_map;
-
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
   }
-}
-
-Result<BTFTypeHeader, BTFError>
-BTF::parseTypeHeader(IFileReader &file_reader) noexcept {
-
-  try {
-    BTFTypeHeader btf_type_common;
-    btf_type_common.name_off = file_reader.u32();
-
-    auto info = file_reader.u32();
-    btf_type_common.vlen = info & 0xFFFFUL;
-    btf_type_common.kind = (info & 0x1F000000UL) >> 24UL;
-    btf_type_common.kind_flag = (info & 0x80000000UL) != 0;
-
-    btf_type_common.size_or_type = file_reader.u32();
-
-    return btf_type_common;
-
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
-  }
-}
-
-Result<BTFType, BTFError>
-BTF::parseIntData(const BTFFileList &btf_file_list,
-                  const BTFTypeHeader &btf_type_header,
-                  IFileReader &file_reader) noexcept {
-
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize,
-      kBTFTypeHeaderSize + kIntBTFTypeSize};
-
-  if (btf_type_header.kind_flag || btf_type_header.vlen != 0) {
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
-            file_range,
-        },
-    };
-  }
-
-  switch (btf_type_header.size_or_type) {
-  case 1:
-  case 2:
-  case 4:
-  case 8:
-  case 16:
-    break;
 
-  default: {
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
-            file_range,
-        },
-    };
-  }
-  }
+  BTFTypeTable btf_type_table;
+  std::uint32_t type_id{1U};
 
-  try {
-    auto name_res = parseString(btf_file_list, btf_type_header.name_off);
-    if (name_res.failed()) {
-      return name_res.takeError();
+  for (auto &btf_file : btf_file_list) {
+    auto type_section_res = loadTypeSection(btf_file, options);
+    if (type_section_res.failed()) {
+      return type_section_res.takeError();
     }
 
-    IntBTFType output;
-    output.name = name_res.takeValue();
-    output.size = btf_type_header.size_or_type;
+    auto type_section = type_section_res.takeValue();
 
-    auto integer_info = file_reader.u32();
+    // The byte order is only checked once per file; from here on, every
+    // record is decoded by a cursor specialized for it
+    auto opt_error = withTypeSectionCursor(
+        type_section, type_section.data, type_section.file_offset,
+        [&](auto &cursor) {
+          auto opt_reserve_error = reserveTypeSection(btf_type_table, cursor);
+          if (opt_reserve_error.has_value()) {
+            return opt_reserve_error;
+          }
 
-    auto encoding = (integer_info & 0x0F000000UL) >> 24;
+          return parseTypeSection(btf_type_table, type_id, btf_file_list,
+                                  cursor);
+        });
 
-    int is_signed = (encoding & 1) != 0;
-    int is_char = (encoding & 2) != 0;
-    int is_bool = (encoding & 4) != 0;
-
-    if (is_signed + is_char + is_bool > 1) {
-      return BTFError{
-          BTFErrorInformation{
-              BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
-              file_range,
-          },
-      };
+    if (opt_error.has_value()) {
+      return opt_error.value();
     }
+  }
 
-    if (is_signed != 0) {
-      output.encoding = IntBTFType::Encoding::Signed;
-
-    } else if (is_char != 0) {
-      output.encoding = IntBTFType::Encoding::Char;
-
-    } else if (is_bool != 0) {
-      output.encoding = IntBTFType::Encoding::Bool;
-
-    } else {
-      output.encoding = IntBTFType::Encoding::None;
-    }
+  return btf_type_table;
+}
 
-    output.bits = integer_info & 0x000000ff;
-    if (output.bits > 128 || output.bits > btf_type_header.size_or_type * 8) {
+Result<BTFTypeTable, BTFError>
+BTF::parseSplitTypeSection(const BTFFileList &btf_file_list,
+                           std::uint32_t first_type_id,
+                           const BTFOptions &options) noexcept {
+  auto type_section_res = loadTypeSection(btf_file_list.back(), options);
+  if (type_section_res.failed()) {
+    return type_section_res.takeError();
+  }
 
-      return BTFError{
-          BTFErrorInformation{
-              BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
-              file_range,
-          },
-      };
-    }
+  auto type_section = type_section_res.takeValue();
 
-    output.offset = (integer_info & 0x00ff0000) >> 16;
-    if (output.offset + output.bits > btf_type_header.size_or_type * 8) {
+  BTFTypeTable btf_type_table(first_type_id);
+  auto type_id = first_type_id;
 
-      return BTFError{
-          BTFErrorInformation{
-              BTFErrorInformation::Code::InvalidIntBTFTypeEncoding,
-              file_range,
-          },
-      };
-    }
+  auto opt_error = withTypeSectionCursor(
+      type_section, type_section.data, type_section.file_offset,
+      [&](auto &cursor) {
+        auto opt_reserve_error = reserveTypeSection(btf_type_table, cursor);
+        if (opt_reserve_error.has_value()) {
+          return opt_reserve_error;
+        }
 
-    return BTFType{output};
+        return parseTypeSection(btf_type_table, type_id, btf_file_list, cursor);
+      });
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+  if (opt_error.has_value()) {
+    return opt_error.value();
   }
-}
 
-Result<BTFType, BTFError>
-BTF::parsePtrData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                  IFileReader &file_reader) noexcept {
+  return btf_type_table;
+}
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+Result<BTFTypeTable, BTFError>
+BTF::decodeTypeSections(const BTFFileList &btf_file_list,
+                        const BTFTypeSectionList &type_section_list,
+                        const BTFTypeIndex &type_index,
+                        const BTFOptions &options) noexcept {
+  // Records are decoded in fixed-size runs, which are handed out in order
+  // to whichever thread is idle
+  try {
+    auto chunk_count = (type_index.size() + kParallelDecodeChunkSize - 1) /
+                       kParallelDecodeChunkSize;
+
+    // Each record is decoded straight into the slot of its type ID
+    std::vector<BTFType> btf_type_list(type_index.size());
+    std::vector<std::optional<BTFError>> chunk_error_list(chunk_count);
+
+    auto thread_count =
+        ThreadPool::getThreadCount(options.thread_count, chunk_count);
+
+    ThreadPool::forEachIndex(
+        chunk_count, thread_count,
+        [&](std::size_t chunk_index) noexcept {
+          auto first_index = chunk_index * kParallelDecodeChunkSize;
+          auto last_index = std::min(first_index + kParallelDecodeChunkSize,
+                                     type_index.size());
+
+          for (auto index = first_index; index < last_index; ++index) {
+            const auto &type_location = type_index[index];
+
+            auto btf_type_res = parseTypeAt(
+                btf_file_list, type_section_list[type_location.section_index],
+                type_location.offset);
+
+            if (btf_type_res.failed()) {
+              chunk_error_list[chunk_index] = btf_type_res.takeError();
+              return;
+            }
+
+            btf_type_list[index] = btf_type_res.takeValue();
+          }
+        });
+
+    // Chunks are checked in ID order, so the first error found is the one
+    // belonging to the lowest type ID
+    for (const auto &opt_chunk_error : chunk_error_list) {
+      if (opt_chunk_error.has_value()) {
+        return opt_chunk_error.value();
+      }
+    }
 
-  if (btf_type_header.name_off != 0 || btf_type_header.kind_flag ||
-      btf_type_header.vlen != 0) {
+    return BTFTypeTable(1U, std::move(btf_type_list));
 
+  } catch (const std::bad_alloc &) {
     return BTFError{
         BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidPtrBTFTypeEncoding,
-            file_range,
+            BTFErrorInformation::Code::MemoryAllocationFailure,
         },
     };
   }
+}
 
-  PtrBTFType output;
-  output.type = btf_type_header.size_or_type;
+std::optional<BTFError>
+BTF::validateTypeSections(const BTFFileList &btf_file_list,
+                          const BTFOptions &options) noexcept {
+  // The encoding checks are the point of this pass, and can't be skipped
+  auto validation_options = options;
+  validation_options.trusted = false;
 
-  return BTFType{output};
-}
+  auto type_section_list_res =
+      loadTypeSections(btf_file_list, validation_options);
 
-Result<BTFType, BTFError>
-BTF::parseConstData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept {
+  if (type_section_list_res.failed()) {
+    return type_section_list_res.takeError();
+  }
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+  auto type_section_list = type_section_list_res.takeValue();
 
-  if (btf_type_header.name_off != 0 || btf_type_header.kind_flag ||
-      btf_type_header.vlen != 0) {
+  auto type_index_res =
+      indexTypeSections(type_section_list, validation_options);
+  if (type_index_res.failed()) {
+    // Same as parseTypeSections(): a record that can't be indexed may come
+    // after an invalid one, and the serial path reports the first of them
+    validation_options.thread_count = 1;
 
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidPtrBTFTypeEncoding,
-            file_range,
-        },
-    };
-  }
+    auto btf_type_table_res =
+        parseTypeSections(btf_file_list, validation_options);
 
-  ConstBTFType output;
-  output.type = btf_type_header.size_or_type;
+    if (btf_type_table_res.failed()) {
+      return btf_type_table_res.takeError();
+    }
 
-  return BTFType{output};
-}
+    return type_index_res.takeError();
+  }
 
-Result<BTFType, BTFError>
-BTF::parseArrayData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept {
+  auto type_index = type_index_res.takeValue();
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize,
-      kBTFTypeHeaderSize + kArrayBTFTypeSize};
+  // Each record is decoded and checked on its own, so the work is split in
+  // the same fixed-size runs used by decodeTypeSections(); the decoded types
+  // are discarded right away
+  try {
+    auto chunk_count = (type_index.size() + kParallelDecodeChunkSize - 1) /
+                       kParallelDecodeChunkSize;
+
+    std::vector<std::optional<BTFError>> chunk_error_list(chunk_count);
+
+    auto thread_count =
+        ThreadPool::getThreadCount(options.thread_count, chunk_count);
+
+    ThreadPool::forEachIndex(
+        chunk_count, thread_count, [&](std::size_t chunk_index) noexcept {
+          auto first_index = chunk_index * kParallelDecodeChunkSize;
+          auto last_index = std::min(first_index + kParallelDecodeChunkSize,
+                                     type_index.size());
+
+          for (auto index = first_index; index < last_index; ++index) {
+            const auto &type_location = type_index[index];
+            const auto &type_section =
+                type_section_list[type_location.section_index];
+
+            auto btf_type_res =
+                parseTypeAt(btf_file_list, type_section, type_location.offset);
+
+            if (btf_type_res.failed()) {
+              chunk_error_list[chunk_index] = btf_type_res.takeError();
+              return;
+            }
+
+            if (!hasValidTypeReferences(btf_type_res.takeValue(),
+                                        type_index.size())) {
+
+              chunk_error_list[chunk_index] = BTFError{
+                  BTFErrorInformation{
+                      BTFErrorInformation::Code::InvalidTypeReference,
+                      BTFErrorInformation::FileRange{
+                          type_section.file_offset + type_location.offset,
+                          kBTFTypeHeaderSize},
+                  },
+              };
+
+              return;
+            }
+          }
+        });
+
+    // The first error found belongs to the lowest type ID
+    for (const auto &opt_error : chunk_error_list) {
+      if (opt_error.has_value()) {
+        return opt_error;
+      }
+    }
 
-  if (btf_type_header.name_off != 0 || btf_type_header.kind_flag ||
-      btf_type_header.vlen != 0 || btf_type_header.size_or_type != 0) {
+    return std::nullopt;
 
+  } catch (const std::bad_alloc &) {
     return BTFError{
         BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidArrayBTFTypeEncoding,
-            file_range,
+            BTFErrorInformation::Code::MemoryAllocationFailure,
         },
     };
   }
+}
 
-  try {
-    ArrayBTFType output;
-    output.type = file_reader.u32();
-    output.index_type = file_reader.u32();
-    output.nelems = file_reader.u32();
-
-    return BTFType{output};
+bool BTF::hasValidTypeReferences(const BTFType &btf_type,
+                                 std::size_t type_count) noexcept {
+  // Type ID 0 is void, and is always valid
+  auto is_valid = [type_count](std::uint32_t type_id) -> bool {
+    return type_id <= type_count;
+  };
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
-  }
+  return std::visit(
+      [&](const auto &type) -> bool {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (std::is_same_v<Type, ArrayBTFType>) {
+          return is_valid(type.type) && is_valid(type.index_type);
+
+        } else if constexpr (std::is_same_v<Type, StructBTFType> ||
+                             std::is_same_v<Type, UnionBTFType>) {
+          return std::all_of(
+              type.member_list.begin(), type.member_list.end(),
+              [&](const auto &member) { return is_valid(member.type); });
+
+        } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+          return is_valid(type.return_type) &&
+                 std::all_of(
+                     type.param_list.begin(), type.param_list.end(),
+                     [&](const auto &param) { return is_valid(param.type); });
+
+        } else if constexpr (std::is_same_v<Type, DataSecBTFType>) {
+          return std::all_of(
+              type.variable_list.begin(), type.variable_list.end(),
+              [&](const auto &variable) { return is_valid(variable.type); });
+
+        } else if constexpr (std::is_same_v<Type, PtrBTFType> ||
+                             std::is_same_v<Type, ConstBTFType> ||
+                             std::is_same_v<Type, VolatileBTFType> ||
+                             std::is_same_v<Type, RestrictBTFType> ||
+                             std::is_same_v<Type, TypedefBTFType> ||
+                             std::is_same_v<Type, FuncBTFType> ||
+                             std::is_same_v<Type, VarBTFType>) {
+          return is_valid(type.type);
+
+        } else {
+          return true;
+        }
+      },
+      btf_type);
 }
 
-Result<BTFType, BTFError>
-BTF::parseTypedefData(const BTFFileList &btf_file_list,
-                      const BTFTypeHeader &btf_type_header,
-                      IFileReader &file_reader) noexcept {
-
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+Result<BTFTypeSectionList, BTFError>
+BTF::loadTypeSections(const BTFFileList &btf_file_list,
+                      const BTFOptions &options) noexcept {
+  try {
+    BTFTypeSectionList type_section_list(btf_file_list.size());
+    std::vector<std::optional<BTFError>> error_list(btf_file_list.size());
+
+    auto thread_count =
+        ThreadPool::getThreadCount(options.thread_count, btf_file_list.size());
+
+    ThreadPool::forEachIndex(
+        btf_file_list.size(), thread_count, [&](std::size_t index) noexcept {
+          auto type_section_res =
+              loadTypeSection(btf_file_list[index], options);
+          if (type_section_res.failed()) {
+            error_list[index] = type_section_res.takeError();
+            return;
+          }
+
+          type_section_list[index] = type_section_res.takeValue();
+        });
+
+    for (auto &opt_error : error_list) {
+      if (opt_error.has_value()) {
+        return opt_error.value();
+      }
+    }
 
-  if (btf_type_header.name_off == 0 || btf_type_header.kind_flag ||
-      btf_type_header.vlen != 0) {
+    return type_section_list;
 
+  } catch (const std::bad_alloc &) {
     return BTFError{
         BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidTypedefBTFTypeEncoding,
-            file_range,
+            BTFErrorInformation::Code::MemoryAllocationFailure,
         },
     };
   }
+}
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
-  if (name_res.failed()) {
-    return name_res.takeError();
+Result<BTFTypeSection, BTFError>
+BTF::loadTypeSection(const BTFFile &btf_file,
+                     const BTFOptions &options) noexcept {
+  BTFTypeSection type_section;
+
+  auto type_section_res = getTypeSection(type_section.buffer, btf_file);
+  if (type_section_res.failed()) {
+    return type_section_res.takeError();
   }
 
-  TypedefBTFType output;
-  output.name = name_res.takeValue();
-  output.type = btf_type_header.size_or_type;
+  type_section.data = type_section_res.takeValue();
 
-  return BTFType{output};
-}
+  type_section.file_offset =
+      static_cast<std::uint64_t>(btf_file.btf_header.hdr_len) +
+      btf_file.btf_header.type_off;
 
-Result<BTFType, BTFError>
-BTF::parseEnumData(const BTFFileList &btf_file_list,
-                   const BTFTypeHeader &btf_type_header,
-                   IFileReader &file_reader) noexcept {
+  type_section.endianness =
+      btf_file.little_endian ? Endianness::Little : Endianness::Big;
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize,
-      kBTFTypeHeaderSize + (btf_type_header.vlen * kEnumValueBTFTypeSize)};
+  type_section.trusted = options.trusted;
 
-  if (btf_type_header.kind_flag) {
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidEnumBTFTypeEncoding,
-            file_range,
-        },
-    };
-  }
+  if (type_section.endianness != kHostEndianness &&
+      options.byte_swap_type_sections) {
+    try {
+      type_section.data =
+          swapTypeSection(type_section.buffer, type_section.data);
 
-  switch (btf_type_header.size_or_type) {
-  case 1:
-  case 2:
-  case 4:
-  case 8:
-    break;
+      type_section.endianness = kHostEndianness;
 
-  default:
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidEnumBTFTypeEncoding,
-            file_range,
-        },
-    };
+    } catch (const std::bad_alloc &) {
+      return BTFError{
+          BTFErrorInformation{
+              BTFErrorInformation::Code::MemoryAllocationFailure,
+          },
+      };
+    }
   }
 
+  return type_section;
+}
+
+Result<BTFTypeIndex, BTFError>
+BTF::indexTypeSections(const BTFTypeSectionList &type_section_list,
+                       const BTFOptions &options) noexcept {
   try {
-    EnumBTFType output;
-    output.size = btf_type_header.size_or_type;
+    // Each section is indexed on its own; the number of records found in
+    // the ones that come before it gives the first type ID of the next
+    std::vector<BTFTypeIndex> section_index_list(type_section_list.size());
+    std::vector<std::optional<BTFError>> error_list(type_section_list.size());
 
-    if (btf_type_header.name_off != 0) {
-      auto name_res = parseString(btf_file_list, btf_type_header.name_off);
-      if (name_res.failed()) {
-        return name_res.takeError();
-      }
+    auto thread_count = ThreadPool::getThreadCount(options.thread_count,
+                                                   type_section_list.size());
 
-      output.opt_name = name_res.takeValue();
-    }
+    ThreadPool::forEachIndex(
+        type_section_list.size(), thread_count,
+        [&](std::size_t index) noexcept {
+          const auto &type_section = type_section_list[index];
+          auto section_index = static_cast<std::uint32_t>(index);
 
-    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
-      auto value_name_off = file_reader.u32();
-      if (value_name_off == 0) {
-        return BTFError{
-            BTFErrorInformation{
-                BTFErrorInformation::Code::InvalidEnumBTFTypeEncoding,
-                file_range,
-            },
-        };
-      }
+          auto &section_type_index = section_index_list[index];
+
+          if (type_section.endianness == Endianness::Little) {
+            BTFCursor<Endianness::Little> cursor(type_section.data,
+                                                 type_section.file_offset);
+
+            error_list[index] =
+                indexTypeSection(section_type_index, section_index, cursor);
+
+          } else {
+            BTFCursor<Endianness::Big> cursor(type_section.data,
+                                              type_section.file_offset);
+
+            error_list[index] =
+                indexTypeSection(section_type_index, section_index, cursor);
+          }
+        });
+
+    std::size_t type_count{0};
 
-      auto value_name_res = parseString(btf_file_list, value_name_off);
-      if (value_name_res.failed()) {
-        return value_name_res.takeError();
+    for (std::size_t index = 0; index < type_section_list.size(); ++index) {
+      if (error_list[index].has_value()) {
+        return error_list[index].value();
       }
 
-      EnumBTFType::Value enum_value{};
-      enum_value.name = value_name_res.takeValue();
-      enum_value.val = static_cast<std::int32_t>(file_reader.u32());
+      type_count += section_index_list[index].size();
+    }
 
-      output.value_list.push_back(std::move(enum_value));
+    if (section_index_list.size() == 1) {
+      return std::move(section_index_list.front());
     }
 
-    return BTFType{output};
+    BTFTypeIndex type_index;
+    type_index.reserve(type_count);
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
-  }
-}
+    for (auto &section_type_index : section_index_list) {
+      type_index.insert(type_index.end(), section_type_index.begin(),
+                        section_type_index.end());
 
-Result<BTFType, BTFError>
-BTF::parseFuncProtoData(const BTFFileList &btf_file_list,
-                        const BTFTypeHeader &btf_type_header,
-                        IFileReader &file_reader) noexcept {
+      section_type_index = {};
+    }
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+    return type_index;
 
-  if (btf_type_header.name_off != 0 || btf_type_header.kind_flag) {
+  } catch (const std::bad_alloc &) {
     return BTFError{
         BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidFuncProtoBTFTypeEncoding,
-            file_range,
+            BTFErrorInformation::Code::MemoryAllocationFailure,
         },
     };
   }
+}
 
-  try {
-    FuncProtoBTFType output;
-    output.return_type = btf_type_header.size_or_type;
+template <typename Cursor>
+std::optional<BTFError>
+BTF::indexTypeSection(BTFTypeIndex &type_index, std::uint32_t section_index,
+                      Cursor &cursor) noexcept {
 
-    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
-      FuncProtoBTFType::Param param{};
+  auto section_start_offset = cursor.offset();
 
-      auto param_name_off = file_reader.u32();
-      if (param_name_off != 0) {
-        auto param_name_res = parseString(btf_file_list, param_name_off);
-        if (param_name_res.failed()) {
-          return param_name_res.takeError();
-        }
+  while (!cursor.atEnd()) {
+    auto current_offset = cursor.offset();
 
-        param.opt_name = param_name_res.takeValue();
-      }
+    auto btf_type_header_res = parseTypeHeader(cursor);
+    if (btf_type_header_res.failed()) {
+      return btf_type_header_res.takeError();
+    }
 
-      param.type = file_reader.u32();
+    auto btf_type_header = btf_type_header_res.takeValue();
 
-      output.param_list.push_back(std::move(param));
-    }
+    // Only the record sizes are needed to move to the next one; the kind
+    // is validated here so that lookups do not fail later on because of it
+    auto opt_data_size = getTypeDataSize(btf_type_header);
+    if (!opt_data_size.has_value()) {
+      auto error_code =
+          btf_type_header.kind > static_cast<std::uint8_t>(BTFKind::Float)
+              ? BTFErrorInformation::Code::InvalidBTFKind
+              : BTFErrorInformation::Code::UnsupportedBTFKind;
 
-    if (!output.param_list.empty()) {
-      const auto &last_element = output.param_list.back();
+      return BTFError{
+          BTFErrorInformation{
+              error_code,
+              BTFErrorInformation::FileRange{current_offset,
+                                             kBTFTypeHeaderSize},
+          },
+      };
+    }
 
-      if (!last_element.opt_name.has_value() && last_element.type == 0) {
-        output.param_list.pop_back();
-        output.is_variadic = true;
-      }
+    if (!cursor.require(opt_data_size.value())) {
+      return convertFileReaderError(cursor.error());
     }
 
-    return BTFType{output};
+    cursor.skip(opt_data_size.value());
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+    BTFTypeLocation type_location;
+    type_location.section_index = section_index;
+    type_location.offset =
+        static_cast<std::uint32_t>(current_offset - section_start_offset);
+    type_location.kind = static_cast<BTFKind>(btf_type_header.kind);
+
+    try {
+      type_index.push_back(type_location);
+
+    } catch (const std::bad_alloc &) {
+      return BTFError{
+          BTFErrorInformation{
+              BTFErrorInformation::Code::MemoryAllocationFailure,
+          },
+      };
+    }
   }
+
+  return std::nullopt;
 }
 
 Result<BTFType, BTFError>
-BTF::parseVolatileData(const BTFFileList &,
-                       const BTFTypeHeader &btf_type_header,
-                       IFileReader &file_reader) noexcept {
+BTF::parseTypeAt(const BTFFileList &btf_file_list,
+                 const BTFTypeSection &type_section,
+                 std::uint32_t offset) noexcept {
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+  auto record = type_section.data.subspan(
+      offset, type_section.data.size() - static_cast<std::size_t>(offset));
 
-  if (btf_type_header.name_off != 0 || btf_type_header.kind_flag ||
-      btf_type_header.vlen != 0) {
+  auto record_file_offset = type_section.file_offset + offset;
 
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidVolatileBTFTypeEncoding,
-            file_range,
-        },
-    };
-  }
+  return withTypeSectionCursor(
+      type_section, record, record_file_offset,
+      [&](auto &cursor) { return parseType(btf_file_list, cursor); });
+}
 
-  VolatileBTFType output;
-  output.type = btf_type_header.size_or_type;
+Result<BTFTypeStore, BTFError>
+BTF::parseStream(std::vector<std::uint8_t> &string_section,
+                 IStream &stream) noexcept {
+  try {
+    SequentialStreamReader reader(stream);
 
-  return BTFType{output};
-}
+    std::array<std::uint8_t, kBTFHeaderSize> header_buffer;
+    reader.read(header_buffer.data(), header_buffer.size());
 
-Result<BTFType, BTFError>
-BTF::parseStructData(const BTFFileList &btf_file_list,
-                     const BTFTypeHeader &btf_type_header,
-                     IFileReader &file_reader) noexcept {
+    BTFFile btf_file;
+    auto &btf_header = btf_file.btf_header;
 
-  StructBTFType output;
-  auto opt_error = parseStructOrUnionData(output, btf_file_list,
-                                          btf_type_header, file_reader);
+    if (header_buffer[0] == (kLittleEndianMagicValue & 0xFF) &&
+        header_buffer[1] == (kLittleEndianMagicValue >> 8)) {
+      btf_file.little_endian = true;
 
-  if (opt_error.has_value()) {
-    return opt_error.value();
-  }
+    } else if (header_buffer[0] == (kBigEndianMagicValue & 0xFF) &&
+               header_buffer[1] == (kBigEndianMagicValue >> 8)) {
+      btf_file.little_endian = false;
 
-  return BTFType{output};
-}
+    } else {
+      return BTFError{
+          BTFErrorInformation{
+              BTFErrorInformation::Code::InvalidMagicValue,
+          },
+      };
+    }
 
-Result<BTFType, BTFError>
-BTF::parseUnionData(const BTFFileList &btf_file_list,
-                    const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept {
+    btf_header.magic = static_cast<std::uint16_t>(kLittleEndianMagicValue);
+    btf_header.version = header_buffer[2];
+    btf_header.flags = header_buffer[3];
 
-  UnionBTFType output;
-  auto opt_error = parseStructOrUnionData(output, btf_file_list,
-                                          btf_type_header, file_reader);
+    auto readHeaderFields = [&](auto &header_cursor) {
+      btf_header.hdr_len = header_cursor.u32();
+      btf_header.type_off = header_cursor.u32();
+      btf_header.type_len = header_cursor.u32();
+      btf_header.str_off = header_cursor.u32();
+      btf_header.str_len = header_cursor.u32();
+    };
 
-  if (opt_error.has_value()) {
-    return opt_error.value();
-  }
+    ByteSpan header_fields(header_buffer.data() + 4, header_buffer.size() - 4);
 
-  return BTFType{output};
-}
+    if (btf_file.little_endian) {
+      BTFCursor<Endianness::Little> header_cursor(header_fields, 4);
+      readHeaderFields(header_cursor);
 
-Result<BTFType, BTFError>
-BTF::parseFwdData(const BTFFileList &btf_file_list,
-                  const BTFTypeHeader &btf_type_header,
-                  IFileReader &file_reader) noexcept {
+    } else {
+      BTFCursor<Endianness::Big> header_cursor(header_fields, 4);
+      readHeaderFields(header_cursor);
+    }
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+    // The string section is allocated upfront, so that names can point
+    // inside it before it is received. The file reader is left empty:
+    // until then, parseString() only validates name offsets and defers the
+    // lookup
+    string_section.assign(btf_header.str_len, 0);
+    btf_file.string_section =
+        ByteSpan(string_section.data(), string_section.size());
 
-  if (btf_type_header.name_off == 0 || btf_type_header.vlen != 0 ||
-      btf_type_header.size_or_type != 0) {
+    BTFFileList btf_file_list;
+    btf_file_list.push_back(std::move(btf_file));
 
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidFwdBTFTypeEncoding,
-            file_range,
-        },
+    const auto &header = btf_file_list.back().btf_header;
+    auto little_endian = btf_file_list.back().little_endian;
+
+    auto type_section_offset =
+        static_cast<std::uint64_t>(header.hdr_len) + header.type_off;
+
+    auto string_section_offset =
+        static_cast<std::uint64_t>(header.hdr_len) + header.str_off;
+
+    // Sections are consumed in file order; they are usually laid out with
+    // the type section first, but this is not required
+    auto readStringSection = [&]() {
+      reader.skipTo(string_section_offset);
+      reader.read(string_section.data(), string_section.size());
     };
-  }
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
-  if (name_res.failed()) {
-    return name_res.takeError();
-  }
+    if (string_section_offset < type_section_offset) {
+      readStringSection();
+    }
 
-  FwdBTFType output;
-  output.name = name_res.takeValue();
-  output.is_union = btf_type_header.kind_flag;
+    reader.skipTo(type_section_offset);
 
-  return BTFType{output};
-}
+    BTFTypeStore btf_type_store;
+    std::optional<BTFError> opt_error;
 
-Result<BTFType, BTFError>
-BTF::parseFuncData(const BTFFileList &btf_file_list,
-                   const BTFTypeHeader &btf_type_header,
-                   IFileReader &file_reader) noexcept {
+    if (little_endian) {
+      opt_error = parseStreamedTypeSection<Endianness::Little>(
+          btf_type_store, btf_file_list, reader, header.type_len);
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+    } else {
+      opt_error = parseStreamedTypeSection<Endianness::Big>(
+          btf_type_store, btf_file_list, reader, header.type_len);
+    }
+
+    if (opt_error.has_value()) {
+      return opt_error.value();
+    }
+
+    if (string_section_offset >= type_section_offset) {
+      readStringSection();
+    }
+
+    ByteSpan string_section_view(string_section.data(), string_section.size());
 
-  if (btf_type_header.name_off == 0 || btf_type_header.kind_flag ||
-      btf_type_header.vlen >= 3) {
+    for (auto id = btf_type_store.firstId(); id < btf_type_store.endId();
+         ++id) {
+      opt_error =
+          resolveDeferredStrings(btf_type_store.at(id), string_section_view);
 
+      if (opt_error.has_value()) {
+        return opt_error.value();
+      }
+    }
+
+    return btf_type_store;
+
+  } catch (const std::bad_alloc &) {
     return BTFError{
         BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidFuncBTFTypeEncoding,
-            file_range,
+            BTFErrorInformation::Code::MemoryAllocationFailure,
         },
     };
-  }
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
-  if (name_res.failed()) {
-    return name_res.takeError();
+  } catch (const FileReaderError &error) {
+    return convertFileReaderError(error);
   }
+}
 
-  FuncBTFType output;
-  output.name = name_res.takeValue();
-  output.type = btf_type_header.size_or_type;
-  output.linkage = static_cast<FuncBTFType::Linkage>(btf_type_header.vlen);
+std::optional<std::size_t>
+BTF::getTypeDataSize(const BTFTypeHeader &btf_type_header) noexcept {
+  return getBTFRecordDataSize(btf_type_header.kind, btf_type_header.vlen);
+}
 
-  return BTFType{output};
+std::string_view BTF::createDeferredString(ByteSpan string_section,
+                                           std::uint32_t offset) noexcept {
+  // The name only records where the string starts; its size is set by
+  // resolveDeferredStrings() once the string section has been received
+  return std::string_view(
+      reinterpret_cast<const char *>(string_section.data()) + offset, 0);
 }
 
-Result<BTFType, BTFError>
-BTF::parseFloatData(const BTFFileList &btf_file_list,
-                    const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept {
+std::optional<BTFError>
+BTF::resolveDeferredStrings(BTFType &btf_type,
+                            ByteSpan string_section) noexcept {
+  return std::visit(
+      [&](auto &type) -> std::optional<BTFError> {
+        using Type = std::decay_t<decltype(type)>;
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+        if constexpr (std::is_same_v<Type, IntBTFType> ||
+                      std::is_same_v<Type, TypedefBTFType> ||
+                      std::is_same_v<Type, FwdBTFType> ||
+                      std::is_same_v<Type, FuncBTFType> ||
+                      std::is_same_v<Type, FloatBTFType> ||
+                      std::is_same_v<Type, VarBTFType> ||
+                      std::is_same_v<Type, DataSecBTFType>) {
+          return resolveDeferredString(type.name, string_section);
 
-  if (btf_type_header.name_off == 0 || btf_type_header.kind_flag ||
-      btf_type_header.vlen != 0) {
+        } else if constexpr (std::is_same_v<Type, StructBTFType> ||
+                             std::is_same_v<Type, UnionBTFType>) {
+          auto opt_error = resolveDeferredString(type.opt_name, string_section);
 
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidFloatBTFTypeEncoding,
-            file_range,
-        },
-    };
-  }
+          for (auto &member : type.member_list) {
+            if (opt_error.has_value()) {
+              break;
+            }
 
-  switch (btf_type_header.size_or_type) {
-  case 2:
-  case 4:
-  case 8:
-  case 12:
-  case 16:
-    break;
+            opt_error = resolveDeferredString(member.opt_name, string_section);
+          }
 
-  default:
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidFloatBTFTypeEncoding,
-            file_range,
-        },
-    };
-  }
+          return opt_error;
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
-  if (name_res.failed()) {
-    return name_res.takeError();
-  }
+        } else if constexpr (std::is_same_v<Type, EnumBTFType>) {
+          auto opt_error = resolveDeferredString(type.opt_name, string_section);
 
-  FloatBTFType output;
-  output.name = name_res.takeValue();
-  output.size = btf_type_header.size_or_type;
+          for (auto &value : type.value_list) {
+            if (opt_error.has_value()) {
+              break;
+            }
 
-  return BTFType{output};
-}
+            opt_error = resolveDeferredString(value.name, string_section);
+          }
 
-Result<BTFType, BTFError>
-BTF::parseRestrictData(const BTFFileList &,
-                       const BTFTypeHeader &btf_type_header,
-                       IFileReader &file_reader) noexcept {
+          return opt_error;
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+        } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+          std::optional<BTFError> opt_error;
 
-  if (btf_type_header.name_off != 0 || btf_type_header.kind_flag ||
-      btf_type_header.vlen != 0) {
+          for (auto &param : type.param_list) {
+            if (opt_error.has_value()) {
+              break;
+            }
 
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidRestrictBTFTypeEncoding,
-            file_range,
-        },
-    };
-  }
+            opt_error = resolveDeferredString(param.opt_name, string_section);
+          }
 
-  RestrictBTFType output;
-  output.type = btf_type_header.size_or_type;
+          return opt_error;
 
-  return BTFType{output};
+        } else {
+          return std::nullopt;
+        }
+      },
+      btf_type);
 }
 
-Result<BTFType, BTFError>
-BTF::parseVarData(const BTFFileList &btf_file_list,
-                  const BTFTypeHeader &btf_type_header,
-                  IFileReader &file_reader) noexcept {
+template <typename Cursor>
+std::optional<BTFError>
+BTF::reserveTypeSection(BTFTypeTable &btf_type_table, Cursor cursor) noexcept {
+  // Only the record headers are read, from a copy of the cursor. Counting
+  // stops at the first invalid record, which parseTypeSection() reports
+  BTFTypeTable::Capacity capacity;
+
+  while (!cursor.atEnd()) {
+    auto btf_type_header_res = parseTypeHeader(cursor);
+    if (btf_type_header_res.failed()) {
+      break;
+    }
+
+    auto btf_type_header = btf_type_header_res.takeValue();
 
-  BTFErrorInformation::FileRange file_range{file_reader.offset() -
-                                                kBTFTypeHeaderSize,
-                                            kBTFTypeHeaderSize + kVarDataSize};
+    auto opt_data_size = getTypeDataSize(btf_type_header);
+    if (!opt_data_size.has_value() || !cursor.require(opt_data_size.value())) {
+      break;
+    }
+
+    cursor.skip(opt_data_size.value());
+
+    capacity.add(static_cast<BTFKind>(btf_type_header.kind),
+                 btf_type_header.vlen);
+  }
 
-  if (btf_type_header.name_off == 0 || btf_type_header.kind_flag ||
-      btf_type_header.vlen != 0) {
+  try {
+    btf_type_table.reserve(capacity);
 
+  } catch (const std::bad_alloc &) {
     return BTFError{
         BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidVarBTFTypeEncoding,
-            file_range,
+            BTFErrorInformation::Code::MemoryAllocationFailure,
         },
     };
   }
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
-  if (name_res.failed()) {
-    return name_res.takeError();
-  }
+  return std::nullopt;
+}
 
-  VarBTFType output;
-  output.name = name_res.takeValue();
-  output.type = btf_type_header.size_or_type;
+template <typename TypeStore, typename Cursor>
+std::optional<BTFError>
+BTF::parseTypeSection(TypeStore &type_store, std::uint32_t &type_id,
+                      const BTFFileList &btf_file_list,
+                      Cursor &cursor) noexcept {
+
+  while (!cursor.atEnd()) {
+    auto btf_type_res = parseType(btf_file_list, cursor);
+    if (btf_type_res.failed()) {
+      return btf_type_res.takeError();
+    }
 
-  try {
-    output.linkage = file_reader.u32();
+    try {
+      type_store.insert(type_id, btf_type_res.takeValue());
 
-    return BTFType{output};
+    } catch (const std::bad_alloc &) {
+      return BTFError{
+          BTFErrorInformation{
+              BTFErrorInformation::Code::MemoryAllocationFailure,
+          },
+      };
+    }
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
+    ++type_id;
   }
+
+  return std::nullopt;
 }
 
-Result<BTFType, BTFError>
-BTF::parseDataSecData(const BTFFileList &btf_file_list,
-                      const BTFTypeHeader &btf_type_header,
-                      IFileReader &file_reader) noexcept {
+template <typename Cursor>
+Result<BTFType, BTFError> BTF::parseType(const BTFFileList &btf_file_list,
+                                         Cursor &cursor) noexcept {
+  BTFTypeBuilder builder(btf_file_list);
+  return BTFTypeDecoder<BTFTypeBuilder>::parseType(builder, cursor);
+}
 
-  BTFErrorInformation::FileRange file_range{
-      file_reader.offset() - kBTFTypeHeaderSize,
-      kBTFTypeHeaderSize + (btf_type_header.vlen * kVarSecInfoSize)};
+Result<ByteSpan, BTFError>
+BTF::getTypeSection(std::vector<std::uint8_t> &buffer,
+                    const BTFFile &btf_file) noexcept {
 
-  if (btf_type_header.name_off == 0 || btf_type_header.kind_flag) {
-    return BTFError{
-        BTFErrorInformation{
-            BTFErrorInformation::Code::InvalidDataSecBTFTypeEncoding,
-            file_range,
-        },
-    };
-  }
+  const auto &btf_header = btf_file.btf_header;
+  const auto &file_reader = *btf_file.file_reader.get();
 
-  auto name_res = parseString(btf_file_list, btf_type_header.name_off);
-  if (name_res.failed()) {
-    return name_res.takeError();
-  }
+  auto type_section_start_offset =
+      static_cast<std::uint64_t>(btf_header.hdr_len) + btf_header.type_off;
 
-  DataSecBTFType output;
-  output.name = name_res.takeValue();
-  output.size = btf_type_header.size_or_type;
+  // Memory-resident files are decoded in place; everything else is read
+  // into the given buffer with a single read operation
+  auto opt_type_section =
+      file_reader.view(type_section_start_offset, btf_header.type_len);
+
+  if (opt_type_section.has_value()) {
+    return opt_type_section.value();
+  }
 
   try {
-    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
-      DataSecBTFType::Variable variable{};
-      variable.type = file_reader.u32();
-      variable.offset = file_reader.u32();
-      variable.size = file_reader.u32();
+    buffer.resize(btf_header.type_len);
+    file_reader.readAt(type_section_start_offset, buffer.data(), buffer.size());
 
-      output.variable_list.push_back(std::move(variable));
-    }
+    return ByteSpan(buffer.data(), buffer.size());
 
-    return BTFType{output};
+  } catch (const std::bad_alloc &) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::MemoryAllocationFailure,
+        },
+    };
 
   } catch (const FileReaderError &error) {
     return convertFileReaderError(error);
   }
 }
 
-Result<std::string, BTFError> BTF::parseString(const BTFFileList &btf_file_list,
-                                               std::uint64_t offset) noexcept {
-  std::uint32_t start_offset{};
+ByteSpan BTF::swapTypeSection(std::vector<std::uint8_t> &buffer,
+                              ByteSpan type_section) {
+  // Every field found in the type section records is a 32-bit word; this
+  // includes the packed `info` word holding kind, kind_flag and vlen. The
+  // whole section can then be converted without walking its records, and
+  // a trailing partial word (if any) is left for the parser to reject
+  if (type_section.data() != buffer.data()) {
+    buffer.resize(type_section.size());
+
+    auto word_count = type_section.size() / 4;
+    std::copy(type_section.begin() + (word_count * 4), type_section.end(),
+              buffer.begin() + static_cast<std::ptrdiff_t>(word_count * 4));
+  }
+
+  byteSwap32(buffer.data(), type_section.data(), type_section.size() / 4);
+  return ByteSpan(buffer.data(), buffer.size());
+}
 
-  for (const auto &btf_file : btf_file_list) {
-    auto end_offset = start_offset + btf_file.btf_header.str_len;
-    auto relative_offset = offset - start_offset;
+template <typename Cursor>
+Result<BTFTypeHeader, BTFError>
+BTF::parseTypeHeader(Cursor &cursor) noexcept {
 
-    if (relative_offset < end_offset) {
-      auto &file_reader = *btf_file.file_reader.get();
+  if (!cursor.require(kBTFTypeHeaderSize)) {
+    return convertFileReaderError(cursor.error());
+  }
 
-      auto absolute_offset = btf_file.btf_header.hdr_len +
-                             btf_file.btf_header.str_off + relative_offset;
+  BTFTypeHeader btf_type_common;
+  btf_type_common.name_off = cursor.u32();
 
-      return parseString(file_reader, absolute_offset);
-    }
+  auto info = cursor.u32();
+  btf_type_common.vlen = info & 0xFFFFUL;
+  btf_type_common.kind =
+      static_cast<std::uint8_t>((info & 0x1F000000UL) >> 24UL);
+  btf_type_common.kind_flag = (info & 0x80000000UL) != 0;
 
-    start_offset = end_offset;
-  }
+  btf_type_common.size_or_type = cursor.u32();
 
-  return BTFError{
-      BTFErrorInformation{
-          BTFErrorInformation::Code::InvalidStringOffset,
-          btfparse::BTFErrorInformation::FileRange{offset, 0},
-      },
-  };
+  return btf_type_common;
 }
 
-Result<std::string, BTFError> BTF::parseString(IFileReader &file_reader,
-                                               std::uint64_t offset) noexcept {
+// Also used by the BTFScanner class
+template Result<BTFTypeHeader, BTFError>
+BTF::parseTypeHeader(BTFCursor<Endianness::Little> &cursor) noexcept;
+
+template Result<BTFTypeHeader, BTFError>
+BTF::parseTypeHeader(BTFCursor<Endianness::Big> &cursor) noexcept;
+
+Result<std::string_view, BTFError>
+BTF::parseString(const BTFFileList &btf_file_list,
+                 std::uint64_t offset) noexcept {
+  // The files are sorted by string offset, so the one that owns the string
+  // is found with a binary search rather than by walking the whole chain
+  auto btf_file_it = std::upper_bound(
+      btf_file_list.begin(), btf_file_list.end(), offset,
+      [](std::uint64_t string_offset, const BTFFile &btf_file) -> bool {
+        return string_offset < btf_file.string_offset;
+      });
+
+  if (btf_file_it == btf_file_list.begin()) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::InvalidStringOffset,
+            btfparse::BTFErrorInformation::FileRange{offset, 0},
+        },
+    };
+  }
 
-  Result<std::string, BTFError> output;
+  const auto &btf_file = *std::prev(btf_file_it);
 
-  auto original_offset{file_reader.offset()};
+  auto relative_offset = offset - btf_file.string_offset;
+  if (relative_offset >= btf_file.btf_header.str_len) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::InvalidStringOffset,
+            btfparse::BTFErrorInformation::FileRange{offset, 0},
+        },
+    };
+  }
 
-  try {
-    file_reader.seek(offset);
-    std::string buffer;
+  const auto &string_section = btf_file.string_section;
 
-    for (;;) {
-      auto ch = static_cast<char>(file_reader.u8());
-      if (ch == 0) {
-        break;
-      }
+  if (!btf_file.file_reader) {
+    return createDeferredString(string_section,
+                                static_cast<std::uint32_t>(relative_offset));
+  }
 
-      buffer.push_back(ch);
-    }
+  auto string_start = reinterpret_cast<const char *>(string_section.data()) +
+                      static_cast<std::size_t>(relative_offset);
 
-    output = buffer;
+  auto terminator = static_cast<const char *>(std::memchr(
+      string_start, 0,
+      string_section.size() - static_cast<std::size_t>(relative_offset)));
 
-  } catch (const FileReaderError &error) {
-    return convertFileReaderError(error);
-  }
+  if (terminator == nullptr) {
+    auto string_section_offset =
+        static_cast<std::uint64_t>(btf_file.btf_header.hdr_len) +
+        btf_file.btf_header.str_off;
 
-  try {
-    file_reader.seek(original_offset);
-  } catch (const FileReaderError &error) {
-    output = convertFileReaderError(error);
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::InvalidStringOffset,
+            btfparse::BTFErrorInformation::FileRange{
+                string_section_offset + relative_offset, 0},
+        },
+    };
   }
 
-  return output;
+  return std::string_view(
+      string_start, static_cast<std::size_t>(terminator - string_start));
 }
 
 } // namespace btfparse
@@ -9,24 +9,81 @@
 #pragma once
 
 #include "btf_types.h"
+#include "btfcursor.h"
+#include "btftypestore.h"
+#include "btftypetable.h"
 
 #include <btfparse/ibtf.h>
 #include <btfparse/ifilereader.h>
 
+#include <array>
+#include <memory>
 #include <vector>
 
 namespace btfparse {
 
 struct BTFFile final {
   BTFHeader btf_header;
-  IFileReader::Ptr file_reader;
+  bool little_endian{true};
+  std::shared_ptr<IFileReader> file_reader;
+
+  // Where the strings of this file start, in the offset space shared by all
+  // the files of a list (see BTF::indexStringSections())
+  std::uint32_t string_offset{};
+
+  // Type names point inside the string section, which is used in place
+  // when the file is memory-resident, and copied to string_buffer otherwise
+  ByteSpan string_section;
+  std::shared_ptr<const std::vector<std::uint8_t>> string_buffer;
 };
 
 using BTFFileList = std::vector<BTFFile>;
 
-using BTFTypeParser = Result<BTFType, BTFError> (*)(const BTFFileList &,
-                                                    const BTFTypeHeader &,
-                                                    IFileReader &);
+// A type section that is ready to be decoded. The data either points inside
+// the file (memory-resident inputs), or into the owned buffer when it had to
+// be read or byte swapped
+struct BTFTypeSection final {
+  ByteSpan data;
+  std::uint64_t file_offset{};
+  Endianness endianness{kHostEndianness};
+  bool trusted{false};
+  std::vector<std::uint8_t> buffer;
+};
+
+using BTFTypeSectionList = std::vector<BTFTypeSection>;
+
+// Where the record for a type ID can be found, used by the lazy mode
+struct BTFTypeLocation final {
+  std::uint32_t section_index{};
+  std::uint32_t offset{};
+  BTFKind kind{BTFKind::Void};
+};
+
+// Indexed by type ID - 1
+using BTFTypeIndex = std::vector<BTFTypeLocation>;
+
+// A run of consecutive types decoded together by the lazy mode. Blocks
+// are never modified once decoded, so handles can read from their table
+struct BTFLazyTypeBlock final {
+  // Records that failed to decode are left out of the table
+  BTFTypeTable btf_type_table;
+
+  // The decoding errors, indexed like the types of the block
+  std::vector<std::optional<BTFError>> error_list;
+};
+
+using BTFLazyTypeBlockList = std::vector<std::unique_ptr<BTFLazyTypeBlock>>;
+
+// The IDs of the types of each kind, in ID order; indexed by BTFKind
+using BTFKindIndex =
+    std::array<std::vector<std::uint32_t>, std::variant_size_v<BTFType>>;
+
+// A split BTF file attached on top of an existing BTF object. The file
+// list starts with the files of the base, which are shared with it
+struct BTFSplit final {
+  BTFFileList btf_file_list;
+  BTFTypeTable btf_type_table;
+};
 
 class BTF final : public IBTF {
 public:
@@ -38,16 +95,70 @@ public:
   virtual std::optional<BTFKind>
   getKind(std::uint32_t id) const noexcept override;
 
+  virtual Result<std::optional<BTFType>, BTFError>
+  getTypeOrError(std::uint32_t id) const noexcept override;
+
+  virtual BTFTypeRef getTypeRef(std::uint32_t id) const noexcept override;
+
   virtual std::uint32_t count() const noexcept override;
   virtual BTFTypeMap getAll() const noexcept override;
 
+  virtual std::optional<BTFError>
+  forEach(const BTFTypeCallback &callback) const noexcept override;
+
+  virtual std::optional<BTFError>
+  forEachOfKind(BTFKind kind,
+                const BTFTypeCallback &callback) const noexcept override;
+
+  virtual Result<BTFSplitHandle, BTFError>
+  attachSplit(const std::filesystem::path &path) noexcept override;
+
+  virtual bool detach(BTFSplitHandle handle) noexcept override;
+
+  virtual std::optional<BTFType>
+  getType(BTFSplitHandle handle, std::uint32_t id) const noexcept override;
+
+  virtual BTFTypeRef getTypeRef(BTFSplitHandle handle,
+                                std::uint32_t id) const noexcept override;
+
+  virtual BTFTypeMap getAll(BTFSplitHandle handle) const noexcept override;
+
 private:
   struct PrivateData;
   std::unique_ptr<PrivateData> d;
 
-  BTF(const PathList &path_list);
+  BTF(BTFFileList btf_file_list, const BTFOptions &options);
+  BTF(BTFTypeStore btf_type_store, std::vector<std::uint8_t> string_section);
+
+  Result<bool, BTFError> visitType(std::uint32_t id,
+                                   BTFTypeTable::AssemblyBuffer &buffer,
+                                   const BTFTypeCallback &callback) const;
+
+  Result<std::uint32_t, BTFError> getBaseTypeCount();
+
+  Result<const BTFLazyTypeBlock *, BTFError>
+  getLazyTypeBlock(std::uint32_t id) const noexcept;
 
 public:
+  static Result<IBTF::Ptr, BTFError> create(BTFFileList btf_file_list,
+                                            const BTFOptions &options) noexcept;
+
+  static Result<IBTF::Ptr, BTFError> createFromStream(IStream &stream) noexcept;
+
+  static Result<BTFFileList, BTFError>
+  openPathList(const PathList &path_list, const BTFOptions &options) noexcept;
+
+  static Result<BTFFileList, BTFError>
+  openBufferList(const BufferList &buffer_list,
+                 const std::shared_ptr<const void> &owner) noexcept;
+
+  static Result<BTFFile, BTFError>
+  openBTFFile(IFileReader::Ptr file_reader) noexcept;
+
+  static void indexStringSections(BTFFileList &btf_file_list) noexcept;
+
+  static BTFKindIndex indexKinds(const IBTF &btf);
+
   static BTFError convertFileReaderError(const FileReaderError &error) noexcept;
 
   static std::optional<BTFError>
@@ -56,92 +167,89 @@ public:
   static Result<BTFHeader, BTFError>
   readBTFHeader(IFileReader &file_reader) noexcept;
 
-  static Result<BTFTypeMap, BTFError>
-  parseTypeSections(const BTFFileList &btf_file_list) noexcept;
+  static Result<BTFTypeTable, BTFError>
+  parseTypeSections(const BTFFileList &btf_file_list,
+                    const BTFOptions &options) noexcept;
 
-  static Result<BTFTypeHeader, BTFError>
-  parseTypeHeader(IFileReader &file_reader) noexcept;
+  static Result<BTFTypeTable, BTFError>
+  decodeTypeSections(const BTFFileList &btf_file_list,
+                     const BTFTypeSectionList &type_section_list,
+                     const BTFTypeIndex &type_index,
+                     const BTFOptions &options) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseIntData(const BTFFileList &btf_file_list,
-               const BTFTypeHeader &btf_type_header,
-               IFileReader &file_reader) noexcept;
+  static std::optional<BTFError>
+  validateTypeSections(const BTFFileList &btf_file_list,
+                       const BTFOptions &options) noexcept;
 
-  static Result<BTFType, BTFError>
-  parsePtrData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-               IFileReader &file_reader) noexcept;
+  static bool hasValidTypeReferences(const BTFType &btf_type,
+                                     std::size_t type_count) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseConstData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                 IFileReader &file_reader) noexcept;
+  static Result<BTFTypeTable, BTFError>
+  parseSplitTypeSection(const BTFFileList &btf_file_list,
+                        std::uint32_t first_type_id,
+                        const BTFOptions &options) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseArrayData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                 IFileReader &file_reader) noexcept;
+  static Result<BTFTypeStore, BTFError>
+  parseStream(std::vector<std::uint8_t> &string_section,
+              IStream &stream) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseTypedefData(const BTFFileList &btf_file_list,
-                   const BTFTypeHeader &btf_type_header,
-                   IFileReader &file_reader) noexcept;
+  static std::optional<std::size_t>
+  getTypeDataSize(const BTFTypeHeader &btf_type_header) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseEnumData(const BTFFileList &btf_file_list,
-                const BTFTypeHeader &btf_type_header,
-                IFileReader &file_reader) noexcept;
+  static std::string_view createDeferredString(ByteSpan string_section,
+                                               std::uint32_t offset) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseFuncProtoData(const BTFFileList &btf_file_list,
-                     const BTFTypeHeader &btf_type_header,
-                     IFileReader &file_reader) noexcept;
+  static std::optional<BTFError>
+  resolveDeferredStrings(BTFType &btf_type, ByteSpan string_section) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseVolatileData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept;
+  static Result<BTFTypeSectionList, BTFError>
+  loadTypeSections(const BTFFileList &btf_file_list,
+                   const BTFOptions &options) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseStructData(const BTFFileList &btf_file_list,
-                  const BTFTypeHeader &btf_type_header,
-                  IFileReader &file_reader) noexcept;
+  static Result<BTFTypeSection, BTFError>
+  loadTypeSection(const BTFFile &btf_file, const BTFOptions &options) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseUnionData(const BTFFileList &btf_file_list,
-                 const BTFTypeHeader &btf_type_header,
-                 IFileReader &file_reader) noexcept;
+  static Result<BTFTypeIndex, BTFError>
+  indexTypeSections(const BTFTypeSectionList &type_section_list,
+                    const BTFOptions &options) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseFwdData(const BTFFileList &btf_file_list,
-               const BTFTypeHeader &btf_type_header,
-               IFileReader &file_reader) noexcept;
+  template <typename Cursor>
+  static std::optional<BTFError>
+  indexTypeSection(BTFTypeIndex &type_index, std::uint32_t section_index,
+                   Cursor &cursor) noexcept;
 
   static Result<BTFType, BTFError>
-  parseFuncData(const BTFFileList &btf_file_list,
-                const BTFTypeHeader &btf_type_header,
-                IFileReader &file_reader) noexcept;
+  parseTypeAt(const BTFFileList &btf_file_list,
+              const BTFTypeSection &type_section,
+              std::uint32_t offset) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseFloatData(const BTFFileList &btf_file_list,
-                 const BTFTypeHeader &btf_type_header,
-                 IFileReader &file_reader) noexcept;
+  static Result<ByteSpan, BTFError>
+  getTypeSection(std::vector<std::uint8_t> &buffer,
+                 const BTFFile &btf_file) noexcept;
 
-  static Result<BTFType, BTFError>
-  parseRestrictData(const BTFFileList &, const BTFTypeHeader &btf_type_header,
-                    IFileReader &file_reader) noexcept;
+  static ByteSpan swapTypeSection(std::vector<std::uint8_t> &buffer,
+                                  ByteSpan type_section);
 
-  static Result<BTFType, BTFError>
-  parseVarData(const BTFFileList &btf_file_list,
-               const BTFTypeHeader &btf_type_header,
-               IFileReader &file_reader) noexcept;
+  template <typename Cursor>
+  static std::optional<BTFError>
+  reserveTypeSection(BTFTypeTable &btf_type_table, Cursor cursor) noexcept;
+
+  // TypeStore is either a BTFTypeStore or a BTFTypeTable
+  template <typename TypeStore, typename Cursor>
+  static std::optional<BTFError>
+  parseTypeSection(TypeStore &type_store, std::uint32_t &type_id,
+                   const BTFFileList &btf_file_list, Cursor &cursor) noexcept;
 
+  template <typename Cursor>
   static Result<BTFType, BTFError>
-  parseDataSecData(const BTFFileList &btf_file_list,
-                   const BTFTypeHeader &btf_type_header,
-                   IFileReader &file_reader) noexcept;
+  parseType(const BTFFileList &btf_file_list, Cursor &cursor) noexcept;
 
-  static Result<std::string, BTFError>
-  parseString(const BTFFileList &btf_file_list, std::uint64_t offset) noexcept;
+  template <typename Cursor>
+  static Result<BTFTypeHeader, BTFError>
+  parseTypeHeader(Cursor &cursor) noexcept;
 
-  static Result<std::string, BTFError>
-  parseString(IFileReader &file_reader, std::uint64_t offset) noexcept;
+  static Result<std::string_view, BTFError>
+  parseString(const BTFFileList &btf_file_list, std::uint64_t offset) noexcept;
 
   friend class IBTF;
 };
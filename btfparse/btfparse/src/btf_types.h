@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <btfparse/ibtf.h>
+
+#include <array>
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -17,14 +20,81 @@ namespace btfparse {
 
 const std::uint32_t kLittleEndianMagicValue{0xEB9F};
 const std::uint32_t kBigEndianMagicValue{0x9FEB};
+const std::size_t kBTFHeaderSize{24U};
 const std::size_t kBTFTypeHeaderSize{12U};
 const std::size_t kIntBTFTypeSize{4U};
 const std::size_t kArrayBTFTypeSize{12U};
 const std::size_t kEnumValueBTFTypeSize{8U};
+const std::size_t kFuncProtoParamSize{8U};
 const std::size_t kStructOrUnionMemberSize{12U};
 const std::size_t kVarDataSize{4U};
 const std::size_t kVarSecInfoSize{12U};
 
+// Describes the data that follows the type header of a record: a part of
+// fixed size, followed by `vlen` entries
+struct BTFRecordLayout final {
+  BTFKind kind{BTFKind::Void};
+  bool supported{false};
+  std::size_t fixed_size{};
+  std::size_t entry_size{};
+};
+
+const std::size_t kBTFKindCount{static_cast<std::size_t>(BTFKind::Float) + 1};
+
+// Record layouts, indexed by kind
+constexpr std::array<BTFRecordLayout, kBTFKindCount> kBTFRecordLayoutTable{{
+    {BTFKind::Void, false, 0U, 0U},
+    {BTFKind::Int, true, kIntBTFTypeSize, 0U},
+    {BTFKind::Ptr, true, 0U, 0U},
+    {BTFKind::Array, true, kArrayBTFTypeSize, 0U},
+    {BTFKind::Struct, true, 0U, kStructOrUnionMemberSize},
+    {BTFKind::Union, true, 0U, kStructOrUnionMemberSize},
+    {BTFKind::Enum, true, 0U, kEnumValueBTFTypeSize},
+    {BTFKind::Fwd, true, 0U, 0U},
+    {BTFKind::Typedef, true, 0U, 0U},
+    {BTFKind::Volatile, true, 0U, 0U},
+    {BTFKind::Const, true, 0U, 0U},
+    {BTFKind::Restrict, true, 0U, 0U},
+    {BTFKind::Func, true, 0U, 0U},
+    {BTFKind::FuncProto, true, 0U, kFuncProtoParamSize},
+    {BTFKind::Var, true, kVarDataSize, 0U},
+    {BTFKind::DataSec, true, 0U, kVarSecInfoSize},
+    {BTFKind::Float, true, 0U, 0U},
+}};
+
+// Returns true if each entry of the given table is stored at the index of
+// its kind
+template <typename Table>
+constexpr bool isIndexedByBTFKind(const Table &table) noexcept {
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    if (static_cast<std::size_t>(table[i].kind) != i) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static_assert(isIndexedByBTFKind(kBTFRecordLayoutTable),
+              "kBTFRecordLayoutTable must be indexed by BTFKind");
+
+// Returns the size of the data following the type header, or std::nullopt
+// if the kind has no record layout
+constexpr std::optional<std::size_t>
+getBTFRecordDataSize(std::uint8_t kind, std::uint16_t vlen) noexcept {
+  if (kind >= kBTFKindCount) {
+    return std::nullopt;
+  }
+
+  const auto &record_layout = kBTFRecordLayoutTable[kind];
+  if (!record_layout.supported) {
+    return std::nullopt;
+  }
+
+  return record_layout.fixed_size +
+         (static_cast<std::size_t>(vlen) * record_layout.entry_size);
+}
+
 struct BTFHeader final {
   std::uint16_t magic{};
   std::uint8_t version{};
@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/bytespan.h>
+#include <btfparse/ifilereader.h>
+
+#include <cstring>
+
+namespace btfparse {
+
+enum class Endianness {
+  Little,
+  Big,
+};
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+constexpr Endianness kHostEndianness{Endianness::Little};
+#else
+constexpr Endianness kHostEndianness{Endianness::Big};
+#endif
+
+// Decodes integers straight out of a memory-resident section. The byte order
+// is fixed at compile time, so that reading from host-endian input is a plain
+// load and cross-endian input only adds a bswap.
+//
+// Bounds are validated once per record with require(); the accessors that
+// follow are unchecked. Failures are reported through the return value
+// rather than with exceptions, so that the decoding loop has no exception
+// handling code. Offsets are absolute file offsets, so that they can be
+// used as-is in the error information.
+//
+// Cursors over trusted input (see BTFOptions::trusted) tell the parsers to
+// skip the encoding checks; bounds are validated either way
+template <Endianness endianness, bool trusted = false> class BTFCursor final {
+  static constexpr bool kSwapBytes{endianness != kHostEndianness};
+
+  ByteSpan buffer;
+  std::uint64_t base_offset{};
+  std::size_t pos{};
+
+  FileReaderErrorInformation::ReadOperation failed_read;
+
+public:
+  static constexpr bool kTrusted{trusted};
+
+  BTFCursor(ByteSpan buffer_, std::uint64_t base_offset_) noexcept
+      : buffer(buffer_), base_offset(base_offset_) {}
+
+  std::uint64_t offset() const noexcept { return base_offset + pos; }
+  bool atEnd() const noexcept { return pos >= buffer.size(); }
+
+  // Returns false if less than `size` bytes are left; the failed read is
+  // then described by error()
+  bool require(std::size_t size) noexcept {
+    if (buffer.contains(pos, size)) {
+      return true;
+    }
+
+    failed_read = FileReaderErrorInformation::ReadOperation{offset(), size};
+    return false;
+  }
+
+  FileReaderError error() const {
+    return FileReaderError(
+        {FileReaderErrorInformation::Code::IOError, failed_read});
+  }
+
+  void skip(std::size_t size) noexcept { pos += size; }
+
+  std::uint32_t u32() noexcept {
+    std::uint32_t value;
+    std::memcpy(&value, buffer.data() + pos, sizeof(value));
+    pos += sizeof(value);
+
+    if constexpr (kSwapBytes) {
+      value = __builtin_bswap32(value);
+    }
+
+    return value;
+  }
+};
+
+} // namespace btfparse
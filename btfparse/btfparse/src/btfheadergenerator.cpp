@@ -142,28 +142,42 @@ BTFHeaderGenerator::BTFHeaderGenerator() {}
 
 bool BTFHeaderGenerator::saveBTFTypeMap(Context &context,
                                         const IBTF::Ptr &btf) {
-  auto btf_type_map = btf->getAll();
-  if (btf_type_map.size() == 0) {
+  // Type IDs are contiguous, so the types are copied straight into the
+  // dense store instead of going through getAll()
+  BTFTypeStore btf_type_store;
+  btf_type_store.extend(btf->count() + 1U);
+
+  std::unordered_set<std::uint32_t> type_id_list;
+
+  auto opt_error =
+      btf->forEach([&](std::uint32_t id, const BTFType &btf_type) -> bool {
+        btf_type_store.insert(id, btf_type);
+        type_id_list.insert(id);
+        return true;
+      });
+
+  if (opt_error.has_value() || btf_type_store.empty()) {
     return false;
   }
 
-  context.btf_type_map = std::move(btf_type_map);
+  context.btf_type_store = std::move(btf_type_store);
+  context.type_id_list = std::move(type_id_list);
   return true;
 }
 
 bool BTFHeaderGenerator::adjustTypeNames(Context &context) {
   std::unordered_set<std::string> visited_name_list;
 
-  for (auto &p : context.btf_type_map) {
-    const auto &id = p.first;
+  const auto &btf_type_store = context.btf_type_store;
 
+  for (const auto &id : context.type_id_list) {
     bool can_be_named{false};
     bool can_be_renamed{false};
     bool uses_tag_type{false};
     bool is_enum{false};
 
     {
-      const auto &btf_type = p.second;
+      const auto &btf_type = btf_type_store.at(id);
 
       switch (btfparse::IBTF::getBTFTypeKind(btf_type)) {
       case btfparse::BTFKind::Struct:
@@ -251,12 +265,12 @@ bool BTFHeaderGenerator::adjustTypeNames(Context &context) {
     }
 
     if (is_enum) {
-      auto &btf_type = p.second;
+      auto &btf_type = context.btf_type_store.at(id);
       auto &enum_btf_type = getTypeAsMutable<EnumBTFType>(btf_type);
 
       bool rename_values{false};
       for (const auto &value : enum_btf_type.value_list) {
-        if (visited_name_list.count(value.name) > 0) {
+        if (visited_name_list.count(std::string(value.name)) > 0) {
           rename_values = true;
           break;
         }
@@ -265,12 +279,13 @@ bool BTFHeaderGenerator::adjustTypeNames(Context &context) {
       if (rename_values) {
         const auto &enum_name = enum_btf_type.opt_name.value();
         for (auto &value : enum_btf_type.value_list) {
-          value.name = enum_name + "_" + value.name;
+          value.name = storeName(context, std::string(enum_name) + "_" +
+                                              std::string(value.name));
         }
       }
 
       for (const auto &value : enum_btf_type.value_list) {
-        visited_name_list.insert(value.name);
+        visited_name_list.insert(std::string(value.name));
       }
     }
   }
@@ -293,18 +308,18 @@ bool BTFHeaderGenerator::materializePadding(Context &context) {
   byte_type.bits = 8;
 
   context.padding_byte_id = generateTypeID(context);
-  context.btf_type_map.insert({context.padding_byte_id, std::move(byte_type)});
+  context.btf_type_store.insert(context.padding_byte_id, std::move(byte_type));
+  context.type_id_list.insert(context.padding_byte_id);
 
   // Add padding to all the struct types
-  for (auto &p : context.btf_type_map) {
-    auto btf_id = p.first;
-    auto &btf_type = p.second;
+  auto &btf_type_store = context.btf_type_store;
 
-    if (IBTF::getBTFTypeKind(btf_type) != BTFKind::Struct) {
+  for (const auto &btf_id : context.type_id_list) {
+    if (btf_type_store.getKind(btf_id) != BTFKind::Struct) {
       continue;
     }
 
-    auto &struct_type = std::get<StructBTFType>(btf_type);
+    auto &struct_type = std::get<StructBTFType>(btf_type_store.at(btf_id));
     if (!materializeStructPadding(context, btf_id, struct_type)) {
       return false;
     }
@@ -499,17 +514,17 @@ BTFHeaderGenerator::getBTFTypeSize(const Context &context,
 std::optional<std::uint32_t>
 BTFHeaderGenerator::getBTFTypeSize(const Context &context, std::uint32_t type) {
 
-  auto type_it = context.btf_type_map.find(type);
-  if (type_it == context.btf_type_map.end()) {
+  auto btf_type = context.btf_type_store.get(type);
+  if (btf_type == nullptr) {
     return std::nullopt;
   }
 
-  return getBTFTypeSize(context, type_it->second);
+  return getBTFTypeSize(context, *btf_type);
 }
 
 bool BTFHeaderGenerator::isValidTypeId(const Context &context,
                                        std::uint32_t id) {
-  return context.btf_type_map.count(id) > 0;
+  return context.btf_type_store.contains(id);
 }
 
 bool BTFHeaderGenerator::isRenameableType(const Context &context,
@@ -518,7 +533,7 @@ bool BTFHeaderGenerator::isRenameableType(const Context &context,
     return false;
   }
 
-  const auto &btf_type = context.btf_type_map.at(id);
+  const auto &btf_type = context.btf_type_store.at(id);
 
   switch (IBTF::getBTFTypeKind(btf_type)) {
   case BTFKind::Struct: {
@@ -549,12 +564,16 @@ void BTFHeaderGenerator::scanTypes(Context &context) {
   context.top_level_type_list.clear();
   context.highest_btf_type_id = 0;
 
-  for (const auto &p : context.btf_type_map) {
-    const auto &id = p.first;
-    context.highest_btf_type_id = std::max(context.highest_btf_type_id, id);
+  const auto &btf_type_store = context.btf_type_store;
 
-    const auto &btf_type = p.second;
-    auto btf_kind = IBTF::getBTFTypeKind(btf_type);
+  for (const auto &id : context.type_id_list) {
+    auto opt_btf_kind = btf_type_store.getKind(id);
+    if (!opt_btf_kind.has_value()) {
+      continue;
+    }
+
+    context.highest_btf_type_id = std::max(context.highest_btf_type_id, id);
+    auto btf_kind = opt_btf_kind.value();
 
     bool skip_type{true};
 
@@ -612,7 +631,7 @@ bool BTFHeaderGenerator::getTypeDependencies(
     return false;
   }
 
-  const auto &btf_type = context.btf_type_map.at(id);
+  const auto &btf_type = context.btf_type_store.at(id);
   switch (IBTF::getBTFTypeKind(btf_type)) {
   case BTFKind::Ptr: {
     const auto &ptr_btf_type = getTypeAs<PtrBTFType>(btf_type);
@@ -652,7 +671,8 @@ bool BTFHeaderGenerator::getTypeDependencies(
       break;
     }
 
-    const auto &child_btf_type = context.btf_type_map.at(typedef_btf_type.type);
+    const auto &child_btf_type =
+        context.btf_type_store.at(typedef_btf_type.type);
     auto child_btf_kind = IBTF::getBTFTypeKind(child_btf_type);
 
     bool recurse{false};
@@ -718,38 +738,55 @@ bool BTFHeaderGenerator::getTypeDependencies(
   return true;
 }
 
+std::string_view BTFHeaderGenerator::storeName(Context &context,
+                                               std::string name) {
+  return context.name_storage.emplace_back(std::move(name));
+}
+
 std::optional<std::string>
 BTFHeaderGenerator::getTypeName(const Context &context, std::uint32_t id) {
   if (!isValidTypeId(context, id)) {
     return std::nullopt;
   }
 
-  const auto &btf_type = context.btf_type_map.at(id);
+  const auto &btf_type = context.btf_type_store.at(id);
 
   switch (IBTF::getBTFTypeKind(btf_type)) {
   case BTFKind::Struct: {
     const auto &struct_btf_type = getTypeAs<StructBTFType>(btf_type);
-    return struct_btf_type.opt_name;
+    if (!struct_btf_type.opt_name.has_value()) {
+      return std::nullopt;
+    }
+
+    return std::string(struct_btf_type.opt_name.value());
   }
 
   case BTFKind::Union: {
     const auto &union_btf_type = getTypeAs<UnionBTFType>(btf_type);
-    return union_btf_type.opt_name;
+    if (!union_btf_type.opt_name.has_value()) {
+      return std::nullopt;
+    }
+
+    return std::string(union_btf_type.opt_name.value());
   }
 
   case BTFKind::Enum: {
     const auto &enum_btf_type = getTypeAs<EnumBTFType>(btf_type);
-    return enum_btf_type.opt_name;
+    if (!enum_btf_type.opt_name.has_value()) {
+      return std::nullopt;
+    }
+
+    return std::string(enum_btf_type.opt_name.value());
   }
 
   case BTFKind::Typedef: {
     const auto &typedef_btf_type = getTypeAs<TypedefBTFType>(btf_type);
-    return typedef_btf_type.name;
+    return std::string(typedef_btf_type.name);
   }
 
   case BTFKind::Fwd: {
     const auto &fwd_btf_type = getTypeAs<FwdBTFType>(btf_type);
-    return fwd_btf_type.name;
+    return std::string(fwd_btf_type.name);
   }
 
   case BTFKind::Void: {
@@ -758,7 +795,7 @@ BTFHeaderGenerator::getTypeName(const Context &context, std::uint32_t id) {
 
   case BTFKind::Int: {
     const auto &int_btf_type = getTypeAs<IntBTFType>(btf_type);
-    return int_btf_type.name;
+    return std::string(int_btf_type.name);
   }
 
   default:
@@ -773,40 +810,40 @@ bool BTFHeaderGenerator::setTypeName(Context &context, std::uint32_t id,
     return false;
   }
 
-  auto &btf_type = context.btf_type_map.at(id);
+  auto &btf_type = context.btf_type_store.at(id);
 
   switch (IBTF::getBTFTypeKind(btf_type)) {
   case BTFKind::Struct: {
     auto &struct_btf_type = getTypeAsMutable<StructBTFType>(btf_type);
-    struct_btf_type.opt_name = name;
+    struct_btf_type.opt_name = storeName(context, name);
 
     return true;
   }
 
   case BTFKind::Union: {
     auto &union_btf_type = getTypeAsMutable<UnionBTFType>(btf_type);
-    union_btf_type.opt_name = name;
+    union_btf_type.opt_name = storeName(context, name);
 
     return true;
   }
 
   case BTFKind::Enum: {
     auto &enum_btf_type = getTypeAsMutable<EnumBTFType>(btf_type);
-    enum_btf_type.opt_name = name;
+    enum_btf_type.opt_name = storeName(context, name);
 
     return true;
   }
 
   case BTFKind::Typedef: {
     auto &typedef_btf_type = getTypeAsMutable<TypedefBTFType>(btf_type);
-    typedef_btf_type.name = name;
+    typedef_btf_type.name = storeName(context, name);
 
     return true;
   }
 
   case BTFKind::Fwd: {
     auto &fwd_btf_type = getTypeAsMutable<FwdBTFType>(btf_type);
-    fwd_btf_type.name = name;
+    fwd_btf_type.name = storeName(context, name);
   }
 
   default:
@@ -865,141 +902,157 @@ bool BTFHeaderGenerator::createTypeTreeHelper(Context &context,
                                               const std::uint32_t &parent,
                                               const std::uint32_t &id) {
 
-  // Ignore void types
-  if (id == 0) {
-    return true;
-  }
+  // Dependency chains can be long enough to overflow the call stack, so
+  // the types are walked with an explicit stack. Dependencies are pushed in
+  // reverse, so that they are visited in the same order as a recursive walk
+  struct PendingType final {
+    bool inside_pointer{false};
+    std::uint32_t parent{0};
+    std::uint32_t id{0};
+  };
 
-  const auto &btf_type = context.btf_type_map.at(id);
+  std::vector<PendingType> pending_type_stack;
+  pending_type_stack.push_back({inside_pointer, parent, id});
 
-  auto btf_kind = btfparse::IBTF::getBTFTypeKind(btf_type);
+  std::vector<std::uint32_t> dependency_list;
 
-  if (btf_kind == btfparse::BTFKind::Ptr) {
-    const auto &ptr_btf_type = getTypeAs<btfparse::PtrBTFType>(btf_type);
-    return createTypeTreeHelper(context, true, parent, ptr_btf_type.type);
+  auto pushDependencies = [&](bool dependency_inside_pointer,
+                                std::uint32_t dependency_parent) {
+    for (auto dependency_it = dependency_list.rbegin();
+         dependency_it != dependency_list.rend(); ++dependency_it) {
 
-  } else if (btf_kind == btfparse::BTFKind::Array) {
-    const auto &array_btf_type = getTypeAs<btfparse::ArrayBTFType>(btf_type);
-    return createTypeTreeHelper(context, inside_pointer, parent,
-                                array_btf_type.type);
+      pending_type_stack.push_back(
+          {dependency_inside_pointer, dependency_parent, *dependency_it});
+    }
+  };
 
-  } else if (btf_kind == btfparse::BTFKind::Volatile) {
-    const auto &volatile_btf_type =
-        getTypeAs<btfparse::VolatileBTFType>(btf_type);
+  while (!pending_type_stack.empty()) {
+    auto pending_type = pending_type_stack.back();
+    pending_type_stack.pop_back();
 
-    return createTypeTreeHelper(context, inside_pointer, parent,
-                                volatile_btf_type.type);
+    const auto &current_parent = pending_type.parent;
+    const auto &current_id = pending_type.id;
 
-  } else if (btf_kind == btfparse::BTFKind::Const) {
-    const auto &const_btf_type = getTypeAs<btfparse::ConstBTFType>(btf_type);
-    return createTypeTreeHelper(context, inside_pointer, parent,
-                                const_btf_type.type);
+    // Ignore void types
+    if (current_id == 0) {
+      continue;
+    }
 
-  } else if (btf_kind == btfparse::BTFKind::Restrict) {
-    const auto &restrict_btf_type =
-        getTypeAs<btfparse::RestrictBTFType>(btf_type);
+    const auto &btf_type = context.btf_type_store.at(current_id);
 
-    return createTypeTreeHelper(context, inside_pointer, parent,
-                                restrict_btf_type.type);
+    auto btf_kind = btfparse::IBTF::getBTFTypeKind(btf_type);
 
-  } else if (btf_kind == btfparse::BTFKind::FuncProto) {
-    const auto &func_proto_btf_type =
-        getTypeAs<btfparse::FuncProtoBTFType>(btf_type);
+    if (btf_kind == btfparse::BTFKind::Ptr) {
+      const auto &ptr_btf_type = getTypeAs<btfparse::PtrBTFType>(btf_type);
+      pending_type_stack.push_back({true, current_parent, ptr_btf_type.type});
 
-    if (!createTypeTreeHelper(context, inside_pointer, parent,
-                              func_proto_btf_type.return_type)) {
-      return false;
-    }
+    } else if (btf_kind == btfparse::BTFKind::Array) {
+      const auto &array_btf_type = getTypeAs<btfparse::ArrayBTFType>(btf_type);
+      pending_type_stack.push_back(
+          {pending_type.inside_pointer, current_parent, array_btf_type.type});
 
-    for (const auto &param : func_proto_btf_type.param_list) {
-      if (!createTypeTreeHelper(context, inside_pointer, parent, param.type)) {
-        return false;
-      }
-    }
+    } else if (btf_kind == btfparse::BTFKind::Volatile) {
+      const auto &volatile_btf_type =
+          getTypeAs<btfparse::VolatileBTFType>(btf_type);
 
-    return true;
+      pending_type_stack.push_back({pending_type.inside_pointer,
+                                    current_parent, volatile_btf_type.type});
 
-  } else if (!isTopLevelTypeDeclaration(context, id)) {
-    if (btf_kind == btfparse::BTFKind::Union ||
-        btf_kind == btfparse::BTFKind::Struct) {
+    } else if (btf_kind == btfparse::BTFKind::Const) {
+      const auto &const_btf_type = getTypeAs<btfparse::ConstBTFType>(btf_type);
+      pending_type_stack.push_back(
+          {pending_type.inside_pointer, current_parent, const_btf_type.type});
 
-      std::vector<std::uint32_t> dependency_list;
-      if (!getTypeDependencies(context, dependency_list, id)) {
-        return false;
-      }
+    } else if (btf_kind == btfparse::BTFKind::Restrict) {
+      const auto &restrict_btf_type =
+          getTypeAs<btfparse::RestrictBTFType>(btf_type);
 
-      // Recurse into anonymous structs/unions. there should be no
-      // way to cull this out: since it has no name, there is no
-      // chance we have seen this already
-      //
-      // Since this is a nested type, we have to clear the 'inside_pointer'
-      // flag
-      for (const auto &dependency_id : dependency_list) {
-        if (!createTypeTreeHelper(context, false, parent, dependency_id)) {
-          return false;
-        }
+      pending_type_stack.push_back({pending_type.inside_pointer,
+                                    current_parent, restrict_btf_type.type});
+
+    } else if (btf_kind == btfparse::BTFKind::FuncProto) {
+      const auto &func_proto_btf_type =
+          getTypeAs<btfparse::FuncProtoBTFType>(btf_type);
+
+      dependency_list.clear();
+      dependency_list.push_back(func_proto_btf_type.return_type);
+
+      for (const auto &param : func_proto_btf_type.param_list) {
+        dependency_list.push_back(param.type);
       }
 
-      return true;
-    }
+      pushDependencies(pending_type.inside_pointer, current_parent);
 
-    switch (btf_kind) {
-    case btfparse::BTFKind::Int:
-    case btfparse::BTFKind::Float:
-    case btfparse::BTFKind::Enum:
-      break;
+    } else if (!isTopLevelTypeDeclaration(context, current_id)) {
+      if (btf_kind == btfparse::BTFKind::Union ||
+          btf_kind == btfparse::BTFKind::Struct) {
 
-    default: {
-      std::stringstream error_buffer;
-      error_buffer << "Invalid state. Encountered a BTF type #" << id
-                   << " of unexpected kind: " << static_cast<int>(btf_kind);
+        if (!getTypeDependencies(context, dependency_list, current_id)) {
+          return false;
+        }
 
-      throw std::logic_error(error_buffer.str());
-    }
-    }
+        // Recurse into anonymous structs/unions. there should be no
+        // way to cull this out: since it has no name, there is no
+        // chance we have seen this already
+        //
+        // Since this is a nested type, we have to clear the 'inside_pointer'
+        // flag
+        pushDependencies(false, current_parent);
+        continue;
+      }
 
-    return true;
-  }
+      switch (btf_kind) {
+      case btfparse::BTFKind::Int:
+      case btfparse::BTFKind::Float:
+      case btfparse::BTFKind::Enum:
+        break;
 
-  auto link_list_it = context.type_tree.find(parent);
-  if (link_list_it == context.type_tree.end()) {
-    auto insert_status = context.type_tree.insert({parent, {}});
-    link_list_it = insert_status.first;
-  }
+      default: {
+        std::stringstream error_buffer;
+        error_buffer << "Invalid state. Encountered a BTF type #" << current_id
+                     << " of unexpected kind: " << static_cast<int>(btf_kind);
 
-  auto &link_list = link_list_it->second;
+        throw std::logic_error(error_buffer.str());
+      }
+      }
 
-  // this is a weak reference only if we can forward declare it
-  auto weak_reference =
-      inside_pointer && (btf_kind == btfparse::BTFKind::Struct ||
-                         btf_kind == btfparse::BTFKind::Union);
+    } else {
+      auto link_list_it = context.type_tree.find(current_parent);
+      if (link_list_it == context.type_tree.end()) {
+        auto insert_status = context.type_tree.insert({current_parent, {}});
+        link_list_it = insert_status.first;
+      }
 
-  auto link_it = link_list.find(id);
-  if (link_it == link_list.end()) {
-    link_list.insert({id, weak_reference});
-  } else {
-    // always upgrade from weak to strong link
-    auto &link_kind = link_it->second;
-    if (link_kind) {
-      link_kind = weak_reference;
-    }
-  }
+      auto &link_list = link_list_it->second;
+
+      // this is a weak reference only if we can forward declare it
+      auto weak_reference = pending_type.inside_pointer &&
+                            (btf_kind == btfparse::BTFKind::Struct ||
+                             btf_kind == btfparse::BTFKind::Union);
+
+      auto link_it = link_list.find(current_id);
+      if (link_it == link_list.end()) {
+        link_list.insert({current_id, weak_reference});
+      } else {
+        // always upgrade from weak to strong link
+        auto &link_kind = link_it->second;
+        if (link_kind) {
+          link_kind = weak_reference;
+        }
+      }
 
-  if (context.visited_type_list.count(id) > 0) {
-    // Do not recurse into this type if we have seen it already
-    return true;
-  }
+      if (context.visited_type_list.count(current_id) > 0) {
+        // Do not recurse into this type if we have seen it already
+        continue;
+      }
 
-  context.visited_type_list.insert(id);
+      context.visited_type_list.insert(current_id);
 
-  std::vector<std::uint32_t> dependency_list;
-  if (!getTypeDependencies(context, dependency_list, id)) {
-    return false;
-  }
+      if (!getTypeDependencies(context, dependency_list, current_id)) {
+        return false;
+      }
 
-  for (const auto &dependency_id : dependency_list) {
-    if (!createTypeTreeHelper(context, false, id, dependency_id)) {
-      return false;
+      pushDependencies(false, current_id);
     }
   }
 
@@ -1017,7 +1070,7 @@ bool BTFHeaderGenerator::adjustTypedefDependencyLoops(Context &context) {
     try_again = false;
 
     for (const auto &struct_id : context.top_level_type_list) {
-      auto &struct_btf_type = context.btf_type_map.at(struct_id);
+      auto &struct_btf_type = context.btf_type_store.at(struct_id);
 
       auto btf_kind = btfparse::IBTF::getBTFTypeKind(struct_btf_type);
       if (btf_kind != btfparse::BTFKind::Struct &&
@@ -1047,7 +1100,7 @@ bool BTFHeaderGenerator::adjustTypedefDependencyLoops(Context &context) {
 
       for (const auto &p : struct_dependency_list) {
         auto &typedef_id = p.first;
-        auto &typedef_btf_type = context.btf_type_map.at(typedef_id);
+        auto &typedef_btf_type = context.btf_type_store.at(typedef_id);
 
         btf_kind = btfparse::IBTF::getBTFTypeKind(typedef_btf_type);
         if (btf_kind != btfparse::BTFKind::Typedef) {
@@ -1149,58 +1202,76 @@ bool BTFHeaderGenerator::createTypeQueue(Context &context) {
 
 bool BTFHeaderGenerator::createTypeQueueHelper(Context &context,
                                                const std::uint32_t &id) {
-  if (id == 0) {
-    return true;
-  }
+  // Each type is queued after the ones it links to. Like in
+  // createTypeTreeHelper(), an explicit stack is used instead of recursion
+  struct PendingType final {
+    std::uint32_t id{0};
+    const std::unordered_map<std::uint32_t, bool> *link_list{nullptr};
+    std::unordered_map<std::uint32_t, bool>::const_iterator link_it;
+  };
+
+  std::vector<PendingType> pending_type_stack;
+
+  auto enterType = [&](std::uint32_t type_id) {
+    if (type_id == 0 || context.visited_type_list.count(type_id) > 0) {
+      return;
+    }
 
-  if (context.visited_type_list.count(id) > 0) {
-    return true;
-  }
+    context.visited_type_list.insert(type_id);
 
-  context.visited_type_list.insert(id);
+    PendingType pending_type;
+    pending_type.id = type_id;
 
-  auto link_list_it = context.type_tree.find(id);
-  if (link_list_it != context.type_tree.end()) {
-    auto &link_list = link_list_it->second;
+    auto link_list_it = context.type_tree.find(type_id);
+    if (link_list_it != context.type_tree.end()) {
+      pending_type.link_list = &link_list_it->second;
+      pending_type.link_it = pending_type.link_list->begin();
+    }
 
-    for (const auto &p : link_list) {
-      auto linked_type = p.first;
-      const auto &weak_reference = p.second;
+    pending_type_stack.push_back(std::move(pending_type));
+  };
 
-      if (weak_reference) {
-        const auto &btf_type = context.btf_type_map.at(linked_type);
+  enterType(id);
 
-        auto btf_kind = btfparse::IBTF::getBTFTypeKind(btf_type);
-        bool is_union;
+  while (!pending_type_stack.empty()) {
+    auto &pending_type = pending_type_stack.back();
 
-        if (btf_kind == btfparse::BTFKind::Union) {
-          is_union = true;
+    if (pending_type.link_list == nullptr ||
+        pending_type.link_it == pending_type.link_list->end()) {
+      context.type_queue.push_back(pending_type.id);
+      pending_type_stack.pop_back();
+      continue;
+    }
 
-        } else if (btf_kind == btfparse::BTFKind::Struct) {
-          is_union = false;
+    auto linked_type = pending_type.link_it->first;
+    auto weak_reference = pending_type.link_it->second;
+    ++pending_type.link_it;
 
-        } else {
-          return false;
-        }
+    if (weak_reference) {
+      const auto &btf_type = context.btf_type_store.at(linked_type);
 
-        auto opt_type_name = getTypeName(context, linked_type);
-        auto fwd_type_id =
-            getOrCreateFwdType(context, is_union, opt_type_name.value());
+      auto btf_kind = btfparse::IBTF::getBTFTypeKind(btf_type);
+      bool is_union;
 
-        if (!createTypeQueueHelper(context, fwd_type_id)) {
-          return false;
-        }
+      if (btf_kind == btfparse::BTFKind::Union) {
+        is_union = true;
 
-        linked_type = fwd_type_id;
-      }
+      } else if (btf_kind == btfparse::BTFKind::Struct) {
+        is_union = false;
 
-      if (!createTypeQueueHelper(context, linked_type)) {
+      } else {
         return false;
       }
+
+      auto opt_type_name = getTypeName(context, linked_type);
+      linked_type =
+          getOrCreateFwdType(context, is_union, opt_type_name.value());
     }
+
+    // This may grow the stack, invalidating `pending_type`
+    enterType(linked_type);
   }
 
-  context.type_queue.push_back(id);
   return true;
 }
 
@@ -1294,10 +1365,11 @@ std::uint32_t BTFHeaderGenerator::getOrCreateFwdType(Context &context,
   if (fwd_type_id_it == context.fwd_type_map.end()) {
     btfparse::FwdBTFType fwd_btf_type;
     fwd_btf_type.is_union = is_union;
-    fwd_btf_type.name = name;
+    fwd_btf_type.name = storeName(context, name);
 
     auto id = generateTypeID(context);
-    context.btf_type_map.insert({id, std::move(fwd_btf_type)});
+    context.btf_type_store.insert(id, std::move(fwd_btf_type));
+    context.type_id_list.insert(id);
 
     auto insert_status = context.fwd_type_map.insert({name, id});
     fwd_type_id_it = insert_status.first;
@@ -1345,7 +1417,8 @@ bool generateStructOrUnion(BTFHeaderGenerator::Context &context,
 
     for (const auto &member : btf_type.member_list) {
       if (member.opt_name.has_value()) {
-        BTFHeaderGenerator::setVariableName(context, member.opt_name.value());
+        BTFHeaderGenerator::setVariableName(
+            context, std::string(member.opt_name.value()));
       }
 
       if (!BTFHeaderGenerator::generateType(context, buffer, member.type,
@@ -1492,7 +1565,7 @@ bool BTFHeaderGenerator::generateType(Context &context,
     buffer << "typedef\n";
     increaseIndent(context);
 
-    setTypedefName(context, typedef_btf_type.name);
+    setTypedefName(context, std::string(typedef_btf_type.name));
     if (!generateType(context, buffer, typedef_btf_type.type, false)) {
       return false;
     }
@@ -1790,7 +1863,7 @@ bool BTFHeaderGenerator::generateType(Context &context,
     return generateVoidType(context, buffer);
   }
 
-  const auto &btf_type = context.btf_type_map.at(id);
+  const auto &btf_type = context.btf_type_store.at(id);
 
   switch (btfparse::IBTF::getBTFTypeKind(btf_type)) {
   case btfparse::BTFKind::Struct: {
@@ -1946,11 +2019,11 @@ void BTFHeaderGenerator::filterFuncProtoModifiers(Context &context) {
 
     const auto &modifier = *modifier_it;
 
-    if (context.btf_type_map.count(modifier) == 0) {
+    if (!context.btf_type_store.contains(modifier)) {
       continue;
     }
 
-    const auto &btf_type = context.btf_type_map.at(modifier);
+    const auto &btf_type = context.btf_type_store.at(modifier);
 
     auto btf_kind = IBTF::getBTFTypeKind(btf_type);
     if (btf_kind == BTFKind::Volatile) {
@@ -1970,7 +2043,7 @@ bool BTFHeaderGenerator::generateLeftModifiers(Context &context,
        modifier_it != context.modifier_list.rend(); ++modifier_it) {
 
     const auto &id = *modifier_it;
-    const auto &btf_type = context.btf_type_map.at(id);
+    const auto &btf_type = context.btf_type_store.at(id);
     auto btf_type_kind = IBTF::getBTFTypeKind(btf_type);
 
     if (btf_type_kind == BTFKind::Volatile) {
@@ -2013,7 +2086,7 @@ bool BTFHeaderGenerator::generateMiddleModifiers(Context &context,
        modifier_it != context.modifier_list.rend(); ++modifier_it) {
 
     const auto &id = *modifier_it;
-    const auto &btf_type = context.btf_type_map.at(id);
+    const auto &btf_type = context.btf_type_store.at(id);
     auto btf_type_kind = IBTF::getBTFTypeKind(btf_type);
 
     if (btf_type_kind == BTFKind::Const) {
@@ -2059,7 +2132,7 @@ bool BTFHeaderGenerator::generateRightModifiers(Context &context,
        modifier_it != context.modifier_list.rend(); ++modifier_it) {
 
     const auto &id = *modifier_it;
-    const auto &btf_type = context.btf_type_map.at(id);
+    const auto &btf_type = context.btf_type_store.at(id);
     auto btf_type_kind = IBTF::getBTFTypeKind(btf_type);
 
     if (btf_type_kind == BTFKind::Array) {
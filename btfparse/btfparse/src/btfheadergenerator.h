@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include "btftypestore.h"
+
+#include <deque>
 #include <sstream>
 #include <unordered_map>
 #include <unordered_set>
@@ -28,10 +31,20 @@ private:
 
 public:
   struct Context final {
-    BTFTypeMap btf_type_map;
+    BTFTypeStore btf_type_store;
+
+    // The IDs in btf_type_store. Types are visited in the order of this
+    // set, which is the one of the type map used before the store, so that
+    // the generated headers keep the same declaration order and names
+    std::unordered_set<std::uint32_t> type_id_list;
+
     std::unordered_set<std::uint32_t> top_level_type_list;
     std::unordered_map<std::string, std::uint32_t> fwd_type_map;
 
+    // Names created while adjusting the types; the type map only holds
+    // views, so they are kept here (a deque never moves its elements)
+    std::deque<std::string> name_storage;
+
     std::uint32_t padding_byte_id{0};
 
     std::uint32_t highest_btf_type_id{0};
@@ -85,6 +98,8 @@ public:
                                   std::vector<std::uint32_t> &dependency_list,
                                   std::uint32_t id);
 
+  static std::string_view storeName(Context &context, std::string name);
+
   static std::optional<std::string> getTypeName(const Context &context,
                                                 std::uint32_t id);
 
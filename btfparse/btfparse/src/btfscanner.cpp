@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfscanner.h"
+
+namespace btfparse {
+
+std::optional<BTFError> BTFScanner::scan(const BTFFileList &btf_file_list,
+                                         const BTFVisitor &visitor) noexcept {
+  try {
+    BTFScanner scanner(btf_file_list);
+
+    // Cross-endian sections are decoded in place, swapping each field as it
+    // is read, rather than paying for a swapped copy of the whole section
+    BTFOptions options;
+    options.byte_swap_type_sections = false;
+
+    std::uint32_t type_id{1U};
+    bool stopped{false};
+
+    for (const auto &btf_file : btf_file_list) {
+      auto type_section_res = BTF::loadTypeSection(btf_file, options);
+      if (type_section_res.failed()) {
+        return type_section_res.takeError();
+      }
+
+      auto type_section = type_section_res.takeValue();
+      std::optional<BTFError> opt_error;
+
+      if (type_section.endianness == Endianness::Little) {
+        BTFCursor<Endianness::Little> cursor(type_section.data,
+                                             type_section.file_offset);
+
+        opt_error = scanner.scanTypeSection(type_id, stopped, cursor, visitor);
+
+      } else {
+        BTFCursor<Endianness::Big> cursor(type_section.data,
+                                          type_section.file_offset);
+
+        opt_error = scanner.scanTypeSection(type_id, stopped, cursor, visitor);
+      }
+
+      if (opt_error.has_value() || stopped) {
+        return opt_error;
+      }
+    }
+
+    return std::nullopt;
+
+  } catch (const std::bad_alloc &) {
+    return BTFError{
+        BTFErrorInformation{
+            BTFErrorInformation::Code::MemoryAllocationFailure,
+        },
+    };
+  }
+}
+
+template <typename Cursor>
+std::optional<BTFError>
+BTFScanner::scanTypeSection(std::uint32_t &type_id, bool &stopped,
+                            Cursor &cursor,
+                            const BTFVisitor &visitor) noexcept {
+
+  while (!cursor.atEnd()) {
+    auto btf_type_res =
+        BTFTypeDecoder<BTFTypeViewBuilder>::parseType(builder, cursor);
+
+    if (btf_type_res.failed()) {
+      return btf_type_res.takeError();
+    }
+
+    try {
+      if (!visitor(type_id, btf_type_res.takeValue())) {
+        stopped = true;
+        break;
+      }
+
+    } catch (...) {
+      // The visitor is user code; exceptions must not cross the noexcept
+      // boundary of IBTF::scan()
+      return BTFError{
+          BTFErrorInformation{
+              BTFErrorInformation::Code::Unknown,
+          },
+      };
+    }
+
+    ++type_id;
+  }
+
+  return std::nullopt;
+}
+
+} // namespace btfparse
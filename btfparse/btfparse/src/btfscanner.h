@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include "btf.h"
+#include "btftypedecoder.h"
+
+#include <btfparse/ibtf.h>
+
+
+namespace btfparse {
+
+// Decodes type sections into BTFTypeView records, which are handed to the
+// visitor one at a time. Names point straight into the string sections,
+// and the lists of the variable-length records are kept in buffers that
+// are reused for the next record, so nothing grows with the type count.
+//
+// Records are decoded by BTFTypeDecoder, like in the BTF class
+class BTFScanner final {
+public:
+  static std::optional<BTFError> scan(const BTFFileList &btf_file_list,
+                                      const BTFVisitor &visitor) noexcept;
+
+private:
+  BTFTypeViewBuilder builder;
+
+  BTFScanner(const BTFFileList &btf_file_list) noexcept
+      : builder(btf_file_list) {}
+
+  template <typename Cursor>
+  std::optional<BTFError> scanTypeSection(std::uint32_t &type_id,
+                                          bool &stopped, Cursor &cursor,
+                                          const BTFVisitor &visitor) noexcept;
+};
+
+} // namespace btfparse
@@ -0,0 +1,763 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include "btf.h"
+
+#include <btfparse/ibtf.h>
+
+#include <array>
+#include <vector>
+
+namespace btfparse {
+
+// Creates the BTFType values stored by the BTF class; each type owns the
+// list of its records
+class BTFTypeBuilder final {
+public:
+  using Type = BTFType;
+  using Int = IntBTFType;
+  using Typedef = TypedefBTFType;
+  using Enum = EnumBTFType;
+  using FuncProto = FuncProtoBTFType;
+  using Struct = StructBTFType;
+  using Union = UnionBTFType;
+  using Fwd = FwdBTFType;
+  using Func = FuncBTFType;
+  using Float = FloatBTFType;
+  using Var = VarBTFType;
+  using DataSec = DataSecBTFType;
+
+  BTFTypeBuilder(const BTFFileList &btf_file_list_) noexcept
+      : btf_file_list(btf_file_list_) {}
+
+  Result<std::string_view, BTFError>
+  parseString(std::uint64_t offset) const noexcept {
+    return BTF::parseString(btf_file_list, offset);
+  }
+
+  // The list that the records of the type are appended to
+  Enum::ValueList &getList(Enum &output) noexcept { return output.value_list; }
+
+  FuncProto::ParamList &getList(FuncProto &output) noexcept {
+    return output.param_list;
+  }
+
+  Struct::MemberList &getList(Struct &output) noexcept {
+    return output.member_list;
+  }
+
+  Union::MemberList &getList(Union &output) noexcept {
+    return output.member_list;
+  }
+
+  DataSec::VariableList &getList(DataSec &output) noexcept {
+    return output.variable_list;
+  }
+
+  // Called once the list of the type is complete
+  template <typename Output> void setList(Output &) noexcept {}
+
+private:
+  const BTFFileList &btf_file_list;
+};
+
+// Creates the BTFTypeView values passed to the IBTF::scan() visitor. The
+// records are kept in buffers that are reused for the next type, so they
+// stop allocating once they have grown to the largest list
+class BTFTypeViewBuilder final {
+public:
+  using Type = BTFTypeView;
+  using Int = IntBTFTypeView;
+  using Typedef = TypedefBTFTypeView;
+  using Enum = EnumBTFTypeView;
+  using FuncProto = FuncProtoBTFTypeView;
+  using Struct = StructBTFTypeView;
+  using Union = UnionBTFTypeView;
+  using Fwd = FwdBTFTypeView;
+  using Func = FuncBTFTypeView;
+  using Float = FloatBTFTypeView;
+  using Var = VarBTFTypeView;
+  using DataSec = DataSecBTFTypeView;
+
+  BTFTypeViewBuilder(const BTFFileList &btf_file_list_) noexcept
+      : btf_file_list(btf_file_list_) {}
+
+  Result<std::string_view, BTFError>
+  parseString(std::uint64_t offset) const noexcept {
+    return BTF::parseString(btf_file_list, offset);
+  }
+
+  std::vector<Enum::Value> &getList(Enum &) noexcept { return value_list; }
+
+  std::vector<FuncProto::Param> &getList(FuncProto &) noexcept {
+    return param_list;
+  }
+
+  // Struct and union members share the same buffer
+  std::vector<Struct::Member> &getList(Struct &) noexcept {
+    return member_list;
+  }
+
+  std::vector<Union::Member> &getList(Union &) noexcept { return member_list; }
+
+  std::vector<DataSec::Variable> &getList(DataSec &) noexcept {
+    return variable_list;
+  }
+
+  void setList(Enum &output) noexcept {
+    output.value_list = Enum::ValueList(value_list.data(), value_list.size());
+  }
+
+  void setList(FuncProto &output) noexcept {
+    output.param_list =
+        FuncProto::ParamList(param_list.data(), param_list.size());
+  }
+
+  void setList(Struct &output) noexcept {
+    output.member_list =
+        Struct::MemberList(member_list.data(), member_list.size());
+  }
+
+  void setList(Union &output) noexcept {
+    output.member_list =
+        Union::MemberList(member_list.data(), member_list.size());
+  }
+
+  void setList(DataSec &output) noexcept {
+    output.variable_list =
+        DataSec::VariableList(variable_list.data(), variable_list.size());
+  }
+
+private:
+  const BTFFileList &btf_file_list;
+
+  std::vector<Enum::Value> value_list;
+  std::vector<FuncProto::Param> param_list;
+  std::vector<Struct::Member> member_list;
+  std::vector<DataSec::Variable> variable_list;
+};
+
+// Decodes type records with either of the builders above. The encoding
+// checks and the error information do not depend on the builder, which
+// only picks the types that are created and where their lists are kept.
+// The checks are skipped for cursors over trusted input
+template <typename Builder> class BTFTypeDecoder final {
+public:
+  using Type = typename Builder::Type;
+
+  template <typename Cursor>
+  static Result<Type, BTFError> parseType(Builder &builder,
+                                          Cursor &cursor) noexcept {
+    auto current_offset = cursor.offset();
+
+    auto btf_type_header_res = BTF::parseTypeHeader(cursor);
+    if (btf_type_header_res.failed()) {
+      return btf_type_header_res.takeError();
+    }
+
+    auto btf_type_header = btf_type_header_res.takeValue();
+
+    BTFErrorInformation::FileRange file_range{current_offset,
+                                              kBTFTypeHeaderSize};
+
+    if (btf_type_header.kind > static_cast<std::uint8_t>(BTFKind::Float)) {
+      return createError(BTFErrorInformation::Code::InvalidBTFKind,
+                         file_range);
+    }
+
+    auto opt_data_size =
+        getBTFRecordDataSize(btf_type_header.kind, btf_type_header.vlen);
+
+    if (!opt_data_size.has_value()) {
+      return createError(BTFErrorInformation::Code::UnsupportedBTFKind,
+                         file_range);
+    }
+
+    // The whole record is bounds checked here, so that the parsers can use
+    // the unchecked cursor accessors
+    if (!cursor.require(opt_data_size.value())) {
+      return BTF::convertFileReaderError(cursor.error());
+    }
+
+    static_assert(isIndexedByBTFKind(kParserTable<Cursor>),
+                  "kParserTable must be indexed by BTFKind");
+
+    const auto &parser = kParserTable<Cursor>[btf_type_header.kind].parser;
+
+    return parser(builder, btf_type_header, cursor);
+  }
+
+private:
+  template <typename Cursor>
+  using Parser = Result<Type, BTFError> (*)(Builder &, const BTFTypeHeader &,
+                                            Cursor &);
+
+  template <typename Cursor> struct ParserEntry final {
+    BTFKind kind{BTFKind::Void};
+    Parser<Cursor> parser{nullptr};
+  };
+
+  using Code = BTFErrorInformation::Code;
+
+  static BTFError
+  createError(Code code, const BTFErrorInformation::FileRange &file_range) {
+    return BTFError{
+        BTFErrorInformation{
+            code,
+            file_range,
+        },
+    };
+  }
+
+  // Empties the list and sizes it up front, so that it does not grow one
+  // element at a time while the record is decoded
+  template <typename List>
+  static std::optional<BTFError> reserveList(List &list,
+                                             std::size_t size) noexcept {
+    try {
+      list.clear();
+      list.reserve(size);
+      return std::nullopt;
+
+    } catch (const std::bad_alloc &) {
+      return BTFError{
+          BTFErrorInformation{
+              Code::MemoryAllocationFailure,
+          },
+      };
+    }
+  }
+
+  template <typename Cursor>
+  static Result<Type, BTFError>
+  parseIntData(Builder &builder, const BTFTypeHeader &btf_type_header,
+               Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize,
+        kBTFTypeHeaderSize + kIntBTFTypeSize};
+
+    if (!Cursor::kTrusted &&
+        (btf_type_header.kind_flag || btf_type_header.vlen != 0)) {
+      return createError(Code::InvalidIntBTFTypeEncoding, file_range);
+    }
+
+    if (!Cursor::kTrusted) {
+      switch (btf_type_header.size_or_type) {
+      case 1:
+      case 2:
+      case 4:
+      case 8:
+      case 16:
+        break;
+
+      default:
+        return createError(Code::InvalidIntBTFTypeEncoding, file_range);
+      }
+    }
+
+    auto name_res = builder.parseString(btf_type_header.name_off);
+    if (name_res.failed()) {
+      return name_res.takeError();
+    }
+
+    typename Builder::Int output;
+    output.name = name_res.takeValue();
+    output.size = btf_type_header.size_or_type;
+
+    auto integer_info = cursor.u32();
+
+    auto encoding = (integer_info & 0x0F000000UL) >> 24;
+
+    int is_signed = (encoding & 1) != 0;
+    int is_char = (encoding & 2) != 0;
+    int is_bool = (encoding & 4) != 0;
+
+    if (!Cursor::kTrusted && is_signed + is_char + is_bool > 1) {
+      return createError(Code::InvalidIntBTFTypeEncoding, file_range);
+    }
+
+    if (is_signed != 0) {
+      output.encoding = IntBTFType::Encoding::Signed;
+
+    } else if (is_char != 0) {
+      output.encoding = IntBTFType::Encoding::Char;
+
+    } else if (is_bool != 0) {
+      output.encoding = IntBTFType::Encoding::Bool;
+
+    } else {
+      output.encoding = IntBTFType::Encoding::None;
+    }
+
+    output.bits = static_cast<std::uint8_t>(integer_info & 0x000000FFU);
+    if (!Cursor::kTrusted &&
+        (output.bits > 128 || output.bits > btf_type_header.size_or_type * 8)) {
+      return createError(Code::InvalidIntBTFTypeEncoding, file_range);
+    }
+
+    output.offset =
+        static_cast<std::uint8_t>((integer_info & 0x00FF0000U) >> 16);
+
+    if (!Cursor::kTrusted &&
+        output.offset + output.bits > btf_type_header.size_or_type * 8) {
+      return createError(Code::InvalidIntBTFTypeEncoding, file_range);
+    }
+
+    return Type{std::move(output)};
+  }
+
+  // Ptr, Const, Volatile and Restrict only refer to another type
+  template <typename Output, Code error_code, typename Cursor>
+  static Result<Type, BTFError>
+  parseReferenceData(Builder &, const BTFTypeHeader &btf_type_header,
+                     Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+
+    if (!Cursor::kTrusted &&
+        (btf_type_header.name_off != 0 || btf_type_header.kind_flag ||
+         btf_type_header.vlen != 0)) {
+      return createError(error_code, file_range);
+    }
+
+    Output output;
+    output.type = btf_type_header.size_or_type;
+
+    return Type{std::move(output)};
+  }
+
+  template <typename Cursor>
+  static Result<Type, BTFError>
+  parseArrayData(Builder &, const BTFTypeHeader &btf_type_header,
+                 Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize,
+        kBTFTypeHeaderSize + kArrayBTFTypeSize};
+
+    if (!Cursor::kTrusted &&
+        (btf_type_header.name_off != 0 || btf_type_header.kind_flag ||
+         btf_type_header.vlen != 0 || btf_type_header.size_or_type != 0)) {
+      return createError(Code::InvalidArrayBTFTypeEncoding, file_range);
+    }
+
+    ArrayBTFType output;
+    output.type = cursor.u32();
+    output.index_type = cursor.u32();
+    output.nelems = cursor.u32();
+
+    return Type{std::move(output)};
+  }
+
+  template <typename Cursor>
+  static Result<Type, BTFError>
+  parseTypedefData(Builder &builder, const BTFTypeHeader &btf_type_header,
+                   Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+
+    if (!Cursor::kTrusted &&
+        (btf_type_header.name_off == 0 || btf_type_header.kind_flag ||
+         btf_type_header.vlen != 0)) {
+      return createError(Code::InvalidTypedefBTFTypeEncoding, file_range);
+    }
+
+    auto name_res = builder.parseString(btf_type_header.name_off);
+    if (name_res.failed()) {
+      return name_res.takeError();
+    }
+
+    typename Builder::Typedef output;
+    output.name = name_res.takeValue();
+    output.type = btf_type_header.size_or_type;
+
+    return Type{std::move(output)};
+  }
+
+  template <typename Cursor>
+  static Result<Type, BTFError>
+  parseEnumData(Builder &builder, const BTFTypeHeader &btf_type_header,
+                Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize,
+        kBTFTypeHeaderSize + (btf_type_header.vlen * kEnumValueBTFTypeSize)};
+
+    if (!Cursor::kTrusted && btf_type_header.kind_flag) {
+      return createError(Code::InvalidEnumBTFTypeEncoding, file_range);
+    }
+
+    if (!Cursor::kTrusted) {
+      switch (btf_type_header.size_or_type) {
+      case 1:
+      case 2:
+      case 4:
+      case 8:
+        break;
+
+      default:
+        return createError(Code::InvalidEnumBTFTypeEncoding, file_range);
+      }
+    }
+
+    typename Builder::Enum output;
+    output.size = btf_type_header.size_or_type;
+
+    if (btf_type_header.name_off != 0) {
+      auto name_res = builder.parseString(btf_type_header.name_off);
+      if (name_res.failed()) {
+        return name_res.takeError();
+      }
+
+      output.opt_name = name_res.takeValue();
+    }
+
+    auto &value_list = builder.getList(output);
+
+    auto opt_error = reserveList(value_list, btf_type_header.vlen);
+    if (opt_error.has_value()) {
+      return opt_error.value();
+    }
+
+    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
+      auto value_name_off = cursor.u32();
+      if (!Cursor::kTrusted && value_name_off == 0) {
+        return createError(Code::InvalidEnumBTFTypeEncoding, file_range);
+      }
+
+      auto value_name_res = builder.parseString(value_name_off);
+      if (value_name_res.failed()) {
+        return value_name_res.takeError();
+      }
+
+      typename Builder::Enum::Value enum_value{};
+      enum_value.name = value_name_res.takeValue();
+      enum_value.val = static_cast<std::int32_t>(cursor.u32());
+
+      value_list.push_back(std::move(enum_value));
+    }
+
+    builder.setList(output);
+    return Type{std::move(output)};
+  }
+
+  template <typename Cursor>
+  static Result<Type, BTFError>
+  parseFuncProtoData(Builder &builder, const BTFTypeHeader &btf_type_header,
+                     Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+
+    if (!Cursor::kTrusted &&
+        (btf_type_header.name_off != 0 || btf_type_header.kind_flag)) {
+      return createError(Code::InvalidFuncProtoBTFTypeEncoding, file_range);
+    }
+
+    typename Builder::FuncProto output;
+    output.return_type = btf_type_header.size_or_type;
+
+    auto &param_list = builder.getList(output);
+
+    auto opt_error = reserveList(param_list, btf_type_header.vlen);
+    if (opt_error.has_value()) {
+      return opt_error.value();
+    }
+
+    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
+      typename Builder::FuncProto::Param param{};
+
+      auto param_name_off = cursor.u32();
+      if (param_name_off != 0) {
+        auto param_name_res = builder.parseString(param_name_off);
+        if (param_name_res.failed()) {
+          return param_name_res.takeError();
+        }
+
+        param.opt_name = param_name_res.takeValue();
+      }
+
+      param.type = cursor.u32();
+
+      param_list.push_back(std::move(param));
+    }
+
+    if (!param_list.empty()) {
+      const auto &last_element = param_list.back();
+
+      if (!last_element.opt_name.has_value() && last_element.type == 0) {
+        param_list.pop_back();
+        output.is_variadic = true;
+      }
+    }
+
+    builder.setList(output);
+    return Type{std::move(output)};
+  }
+
+  template <typename Output, typename Cursor>
+  static Result<Type, BTFError>
+  parseStructOrUnionData(Builder &builder,
+                         const BTFTypeHeader &btf_type_header,
+                         Cursor &cursor) noexcept {
+
+    Output output;
+    output.size = btf_type_header.size_or_type;
+
+    if (btf_type_header.name_off != 0) {
+      auto name_res = builder.parseString(btf_type_header.name_off);
+      if (name_res.failed()) {
+        return name_res.takeError();
+      }
+
+      output.opt_name = name_res.takeValue();
+    }
+
+    auto &member_list = builder.getList(output);
+
+    auto opt_error = reserveList(member_list, btf_type_header.vlen);
+    if (opt_error.has_value()) {
+      return opt_error.value();
+    }
+
+    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
+      typename Output::Member member{};
+
+      auto member_name_off = cursor.u32();
+      if (member_name_off != 0) {
+        auto member_name_res = builder.parseString(member_name_off);
+        if (member_name_res.failed()) {
+          return member_name_res.takeError();
+        }
+
+        member.opt_name = member_name_res.takeValue();
+      }
+
+      member.type = cursor.u32();
+
+      auto offset = cursor.u32();
+      if (btf_type_header.kind_flag) {
+        member.offset = offset & 0xFFFFFFU;
+        member.opt_bitfield_size = static_cast<std::uint8_t>(offset >> 24);
+
+      } else {
+        member.offset = offset;
+      }
+
+      member_list.push_back(std::move(member));
+    }
+
+    builder.setList(output);
+    return Type{std::move(output)};
+  }
+
+  template <typename Cursor>
+  static Result<Type, BTFError>
+  parseFwdData(Builder &builder, const BTFTypeHeader &btf_type_header,
+               Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+
+    if (!Cursor::kTrusted &&
+        (btf_type_header.name_off == 0 || btf_type_header.vlen != 0 ||
+         btf_type_header.size_or_type != 0)) {
+      return createError(Code::InvalidFwdBTFTypeEncoding, file_range);
+    }
+
+    auto name_res = builder.parseString(btf_type_header.name_off);
+    if (name_res.failed()) {
+      return name_res.takeError();
+    }
+
+    typename Builder::Fwd output;
+    output.name = name_res.takeValue();
+    output.is_union = btf_type_header.kind_flag;
+
+    return Type{std::move(output)};
+  }
+
+  template <typename Cursor>
+  static Result<Type, BTFError>
+  parseFuncData(Builder &builder, const BTFTypeHeader &btf_type_header,
+                Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+
+    if (!Cursor::kTrusted &&
+        (btf_type_header.name_off == 0 || btf_type_header.kind_flag ||
+         btf_type_header.vlen >= 3)) {
+      return createError(Code::InvalidFuncBTFTypeEncoding, file_range);
+    }
+
+    auto name_res = builder.parseString(btf_type_header.name_off);
+    if (name_res.failed()) {
+      return name_res.takeError();
+    }
+
+    typename Builder::Func output;
+    output.name = name_res.takeValue();
+    output.type = btf_type_header.size_or_type;
+    output.linkage = static_cast<FuncBTFType::Linkage>(btf_type_header.vlen);
+
+    return Type{std::move(output)};
+  }
+
+  template <typename Cursor>
+  static Result<Type, BTFError>
+  parseFloatData(Builder &builder, const BTFTypeHeader &btf_type_header,
+                 Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize, kBTFTypeHeaderSize};
+
+    if (!Cursor::kTrusted &&
+        (btf_type_header.name_off == 0 || btf_type_header.kind_flag ||
+         btf_type_header.vlen != 0)) {
+      return createError(Code::InvalidFloatBTFTypeEncoding, file_range);
+    }
+
+    if (!Cursor::kTrusted) {
+      switch (btf_type_header.size_or_type) {
+      case 2:
+      case 4:
+      case 8:
+      case 12:
+      case 16:
+        break;
+
+      default:
+        return createError(Code::InvalidFloatBTFTypeEncoding, file_range);
+      }
+    }
+
+    auto name_res = builder.parseString(btf_type_header.name_off);
+    if (name_res.failed()) {
+      return name_res.takeError();
+    }
+
+    typename Builder::Float output;
+    output.name = name_res.takeValue();
+    output.size = btf_type_header.size_or_type;
+
+    return Type{std::move(output)};
+  }
+
+  template <typename Cursor>
+  static Result<Type, BTFError>
+  parseVarData(Builder &builder, const BTFTypeHeader &btf_type_header,
+               Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize,
+        kBTFTypeHeaderSize + kVarDataSize};
+
+    if (!Cursor::kTrusted &&
+        (btf_type_header.name_off == 0 || btf_type_header.kind_flag ||
+         btf_type_header.vlen != 0)) {
+      return createError(Code::InvalidVarBTFTypeEncoding, file_range);
+    }
+
+    auto name_res = builder.parseString(btf_type_header.name_off);
+    if (name_res.failed()) {
+      return name_res.takeError();
+    }
+
+    typename Builder::Var output;
+    output.name = name_res.takeValue();
+    output.type = btf_type_header.size_or_type;
+
+    output.linkage = cursor.u32();
+
+    return Type{std::move(output)};
+  }
+
+  template <typename Cursor>
+  static Result<Type, BTFError>
+  parseDataSecData(Builder &builder, const BTFTypeHeader &btf_type_header,
+                   Cursor &cursor) noexcept {
+
+    BTFErrorInformation::FileRange file_range{
+        cursor.offset() - kBTFTypeHeaderSize,
+        kBTFTypeHeaderSize + (btf_type_header.vlen * kVarSecInfoSize)};
+
+    if (!Cursor::kTrusted &&
+        (btf_type_header.name_off == 0 || btf_type_header.kind_flag)) {
+      return createError(Code::InvalidDataSecBTFTypeEncoding, file_range);
+    }
+
+    auto name_res = builder.parseString(btf_type_header.name_off);
+    if (name_res.failed()) {
+      return name_res.takeError();
+    }
+
+    typename Builder::DataSec output;
+    output.name = name_res.takeValue();
+    output.size = btf_type_header.size_or_type;
+
+    auto &variable_list = builder.getList(output);
+
+    auto opt_error = reserveList(variable_list, btf_type_header.vlen);
+    if (opt_error.has_value()) {
+      return opt_error.value();
+    }
+
+    for (std::uint32_t i = 0; i < btf_type_header.vlen; ++i) {
+      typename Builder::DataSec::Variable variable{};
+      variable.type = cursor.u32();
+      variable.offset = cursor.u32();
+      variable.size = cursor.u32();
+
+      variable_list.push_back(std::move(variable));
+    }
+
+    builder.setList(output);
+    return Type{std::move(output)};
+  }
+
+  // Record parsers, indexed by kind
+  template <typename Cursor>
+  static constexpr std::array<ParserEntry<Cursor>, kBTFKindCount>
+      kParserTable{{
+          {BTFKind::Void, nullptr},
+          {BTFKind::Int, parseIntData<Cursor>},
+          {BTFKind::Ptr,
+           parseReferenceData<PtrBTFType, Code::InvalidPtrBTFTypeEncoding,
+                              Cursor>},
+          {BTFKind::Array, parseArrayData<Cursor>},
+          {BTFKind::Struct,
+           parseStructOrUnionData<typename Builder::Struct, Cursor>},
+          {BTFKind::Union,
+           parseStructOrUnionData<typename Builder::Union, Cursor>},
+          {BTFKind::Enum, parseEnumData<Cursor>},
+          {BTFKind::Fwd, parseFwdData<Cursor>},
+          {BTFKind::Typedef, parseTypedefData<Cursor>},
+          {BTFKind::Volatile,
+           parseReferenceData<VolatileBTFType,
+                              Code::InvalidVolatileBTFTypeEncoding, Cursor>},
+          {BTFKind::Const,
+           parseReferenceData<ConstBTFType, Code::InvalidPtrBTFTypeEncoding,
+                              Cursor>},
+          {BTFKind::Restrict,
+           parseReferenceData<RestrictBTFType,
+                              Code::InvalidRestrictBTFTypeEncoding, Cursor>},
+          {BTFKind::Func, parseFuncData<Cursor>},
+          {BTFKind::FuncProto, parseFuncProtoData<Cursor>},
+          {BTFKind::Var, parseVarData<Cursor>},
+          {BTFKind::DataSec, parseDataSecData<Cursor>},
+          {BTFKind::Float, parseFloatData<Cursor>},
+      }};
+};
+
+} // namespace btfparse
@@ -0,0 +1,160 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btftypetable.h"
+
+#include <type_traits>
+
+namespace btfparse {
+
+namespace {
+
+template <typename Type>
+constexpr bool kHasName = std::is_same_v<Type, IntBTFType> ||
+                          std::is_same_v<Type, TypedefBTFType> ||
+                          std::is_same_v<Type, FwdBTFType> ||
+                          std::is_same_v<Type, FuncBTFType> ||
+                          std::is_same_v<Type, FloatBTFType> ||
+                          std::is_same_v<Type, VarBTFType> ||
+                          std::is_same_v<Type, DataSecBTFType>;
+
+template <typename Type>
+constexpr bool kHasOptionalName = std::is_same_v<Type, StructBTFType> ||
+                                  std::is_same_v<Type, UnionBTFType> ||
+                                  std::is_same_v<Type, EnumBTFType>;
+
+template <typename Type>
+constexpr bool kHasType = std::is_same_v<Type, PtrBTFType> ||
+                          std::is_same_v<Type, ConstBTFType> ||
+                          std::is_same_v<Type, VolatileBTFType> ||
+                          std::is_same_v<Type, RestrictBTFType> ||
+                          std::is_same_v<Type, TypedefBTFType> ||
+                          std::is_same_v<Type, FuncBTFType> ||
+                          std::is_same_v<Type, VarBTFType> ||
+                          std::is_same_v<Type, ArrayBTFType>;
+
+template <typename Type>
+constexpr bool kHasSize = std::is_same_v<Type, IntBTFType> ||
+                          std::is_same_v<Type, StructBTFType> ||
+                          std::is_same_v<Type, UnionBTFType> ||
+                          std::is_same_v<Type, EnumBTFType> ||
+                          std::is_same_v<Type, DataSecBTFType> ||
+                          std::is_same_v<Type, FloatBTFType>;
+
+std::optional<std::string_view> getName(const BTFType &btf_type) noexcept {
+  return std::visit(
+      [](const auto &type) -> std::optional<std::string_view> {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (kHasName<Type>) {
+          return type.name;
+
+        } else if constexpr (kHasOptionalName<Type>) {
+          return type.opt_name;
+
+        } else {
+          return std::nullopt;
+        }
+      },
+      btf_type);
+}
+
+std::optional<std::uint32_t> getSize(const BTFType &btf_type) noexcept {
+  return std::visit(
+      [](const auto &type) -> std::optional<std::uint32_t> {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (kHasSize<Type>) {
+          return type.size;
+
+        } else {
+          return std::nullopt;
+        }
+      },
+      btf_type);
+}
+
+} // namespace
+
+std::optional<std::string_view> BTFMemberRef::name() const noexcept {
+  return BTFTypeTable::toOptionalName(table->memberArrays().name_list[index]);
+}
+
+std::uint32_t BTFMemberRef::type() const noexcept {
+  return table->memberArrays().type_list[index];
+}
+
+std::uint32_t BTFMemberRef::offset() const noexcept {
+  return table->memberArrays().offset_list[index];
+}
+
+std::optional<std::uint8_t> BTFMemberRef::bitfieldSize() const noexcept {
+  return table->memberArrays().bitfield_size_list[index];
+}
+
+BTFStructRef::BTFStructRef(const BTFTypeTable *table_,
+                           std::uint32_t type_id_) noexcept
+    : table(table_), type_id(type_id_) {
+
+  auto slice = table->getSlice(type_id);
+  first_member = slice.start;
+  member_count = slice.count;
+}
+
+bool BTFStructRef::isUnion() const noexcept {
+  return table->getKind(type_id) == BTFKind::Union;
+}
+
+std::optional<std::string_view> BTFStructRef::name() const noexcept {
+  return getName(*table->getFixedPart(type_id));
+}
+
+std::uint32_t BTFStructRef::size() const noexcept {
+  return getSize(*table->getFixedPart(type_id)).value_or(0);
+}
+
+BTFKind BTFTypeRef::kind() const noexcept {
+  return table->getKind(type_id).value_or(BTFKind::Void);
+}
+
+std::optional<std::string_view> BTFTypeRef::name() const noexcept {
+  return getName(*table->getFixedPart(type_id));
+}
+
+std::optional<std::uint32_t> BTFTypeRef::type() const noexcept {
+  return std::visit(
+      [](const auto &type) -> std::optional<std::uint32_t> {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (kHasType<Type>) {
+          return type.type;
+
+        } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+          return type.return_type;
+
+        } else {
+          return std::nullopt;
+        }
+      },
+      *table->getFixedPart(type_id));
+}
+
+std::optional<std::uint32_t> BTFTypeRef::size() const noexcept {
+  return getSize(*table->getFixedPart(type_id));
+}
+
+std::optional<BTFStructRef> BTFTypeRef::asStruct() const noexcept {
+  auto type_kind = kind();
+  if (type_kind != BTFKind::Struct && type_kind != BTFKind::Union) {
+    return std::nullopt;
+  }
+
+  return BTFStructRef(table, type_id);
+}
+
+} // namespace btfparse
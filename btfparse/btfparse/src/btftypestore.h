@@ -0,0 +1,182 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtf.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace btfparse {
+
+// Types indexed by ID. IDs are contiguous, so each type is stored at
+// `id - first_id`, and its kind is kept in a parallel array that is read
+// without touching the variant. Empty slots hold std::monostate, and have
+// the Void kind, which is never the kind of a stored type.
+//
+// Adding a type past the last slot may move the others, so references
+// must not be held across insert() calls. Methods that allocate throw
+// std::bad_alloc
+class BTFTypeStore final {
+public:
+  BTFTypeStore(std::uint32_t first_id_ = 1U) : first_id(first_id_) {}
+
+  // Takes a list of types that start at `first_id_`, in ID order
+  BTFTypeStore(std::uint32_t first_id_, std::vector<BTFType> btf_type_list_)
+      : first_id(first_id_), btf_type_list(std::move(btf_type_list_)) {
+
+    kind_list.reserve(btf_type_list.size());
+
+    for (const auto &btf_type : btf_type_list) {
+      auto kind = IBTF::getBTFTypeKind(btf_type);
+      kind_list.push_back(kind);
+
+      if (kind != BTFKind::Void) {
+        ++type_count;
+      }
+    }
+  }
+
+  std::uint32_t firstId() const noexcept { return first_id; }
+
+  // One past the last slot
+  std::uint32_t endId() const noexcept {
+    return first_id + static_cast<std::uint32_t>(kind_list.size());
+  }
+
+  // Number of stored types
+  std::uint32_t size() const noexcept { return type_count; }
+  bool empty() const noexcept { return type_count == 0; }
+
+  // Creates empty slots for the IDs before `end_id`
+  void extend(std::uint32_t end_id) {
+    if (end_id <= endId()) {
+      return;
+    }
+
+    auto slot_count = static_cast<std::size_t>(end_id - first_id);
+    btf_type_list.resize(slot_count);
+    kind_list.resize(slot_count, BTFKind::Void);
+  }
+
+  // Allocates the slots for the IDs before `end_id`, without creating them
+  void reserve(std::uint32_t end_id) {
+    if (end_id <= first_id) {
+      return;
+    }
+
+    auto slot_count = static_cast<std::size_t>(end_id - first_id);
+    btf_type_list.reserve(slot_count);
+    kind_list.reserve(slot_count);
+  }
+
+  // Stores the type with the given ID, replacing the existing one
+  void insert(std::uint32_t id, BTFType btf_type) {
+    if (id < first_id) {
+      throw std::out_of_range("Invalid type ID");
+    }
+
+    // Appending in ID order is amortized constant time, as the lists grow
+    // geometrically
+    extend(id + 1U);
+
+    auto index = static_cast<std::size_t>(id - first_id);
+    auto kind = IBTF::getBTFTypeKind(btf_type);
+
+    if (kind_list[index] == BTFKind::Void) {
+      if (kind != BTFKind::Void) {
+        ++type_count;
+      }
+
+    } else if (kind == BTFKind::Void) {
+      --type_count;
+    }
+
+    btf_type_list[index] = std::move(btf_type);
+    kind_list[index] = kind;
+  }
+
+  bool contains(std::uint32_t id) const noexcept {
+    return getKind(id).has_value();
+  }
+
+  std::optional<BTFKind> getKind(std::uint32_t id) const noexcept {
+    if (id < first_id || id >= endId()) {
+      return std::nullopt;
+    }
+
+    auto kind = kind_list[static_cast<std::size_t>(id - first_id)];
+    if (kind == BTFKind::Void) {
+      return std::nullopt;
+    }
+
+    return kind;
+  }
+
+  // Returns nullptr if the type is not stored
+  const BTFType *get(std::uint32_t id) const noexcept {
+    if (!contains(id)) {
+      return nullptr;
+    }
+
+    return &btf_type_list[static_cast<std::size_t>(id - first_id)];
+  }
+
+  BTFType *get(std::uint32_t id) noexcept {
+    if (!contains(id)) {
+      return nullptr;
+    }
+
+    return &btf_type_list[static_cast<std::size_t>(id - first_id)];
+  }
+
+  // Same as above, but throws std::out_of_range like std::unordered_map
+  const BTFType &at(std::uint32_t id) const {
+    auto btf_type = get(id);
+    if (btf_type == nullptr) {
+      throw std::out_of_range("Invalid type ID");
+    }
+
+    return *btf_type;
+  }
+
+  BTFType &at(std::uint32_t id) {
+    auto btf_type = get(id);
+    if (btf_type == nullptr) {
+      throw std::out_of_range("Invalid type ID");
+    }
+
+    return *btf_type;
+  }
+
+  // Copies the stored types to a map
+  BTFTypeMap toMap() const {
+    BTFTypeMap btf_type_map;
+    btf_type_map.reserve(type_count);
+
+    for (auto id = first_id; id < endId(); ++id) {
+      auto btf_type = get(id);
+      if (btf_type != nullptr) {
+        btf_type_map.insert({id, *btf_type});
+      }
+    }
+
+    return btf_type_map;
+  }
+
+private:
+  std::uint32_t first_id{1U};
+  std::uint32_t type_count{};
+
+  std::vector<BTFType> btf_type_list;
+  std::vector<BTFKind> kind_list;
+};
+
+} // namespace btfparse
@@ -0,0 +1,376 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btftypetable.h"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace btfparse {
+
+namespace {
+
+template <typename Type>
+constexpr bool kHasMemberList = std::is_same_v<Type, StructBTFType> ||
+                                std::is_same_v<Type, UnionBTFType>;
+
+// Makes room for exactly `count` more records in each array
+template <typename... Arrays>
+void reserveRecords(std::size_t count, Arrays &...arrays) {
+  (arrays.reserve(arrays.size() + count), ...);
+}
+
+// Same as above, but the arrays still grow geometrically, so that
+// appending one type at a time stays amortized constant time
+template <typename... Arrays>
+void growRecords(std::size_t count, Arrays &...arrays) {
+  auto grow = [count](auto &array) {
+    auto required_size = array.size() + count;
+    if (required_size > array.capacity()) {
+      array.reserve(std::max(required_size, array.capacity() * 2));
+    }
+  };
+
+  (grow(arrays), ...);
+}
+
+template <typename Array>
+BTFTypeTable::Slice createSlice(const Array &array, std::size_t count) {
+  return BTFTypeTable::Slice{
+      static_cast<std::uint32_t>(array.size()),
+      static_cast<std::uint32_t>(count),
+  };
+}
+
+std::string_view fromOptionalName(
+    const std::optional<std::string_view> &opt_name) noexcept {
+  return opt_name.value_or(std::string_view());
+}
+
+} // namespace
+
+BTFTypeTable::BTFTypeTable(std::uint32_t first_id)
+    : btf_type_store(first_id) {}
+
+BTFTypeTable::BTFTypeTable(std::uint32_t first_id,
+                           std::vector<BTFType> btf_type_list)
+    : btf_type_store(first_id) {
+
+  Capacity capacity;
+
+  for (const auto &btf_type : btf_type_list) {
+    auto record_count = std::visit(
+        [](const auto &type) -> std::size_t {
+          using Type = std::decay_t<decltype(type)>;
+
+          if constexpr (kHasMemberList<Type>) {
+            return type.member_list.size();
+
+          } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+            return type.param_list.size();
+
+          } else if constexpr (std::is_same_v<Type, EnumBTFType>) {
+            return type.value_list.size();
+
+          } else if constexpr (std::is_same_v<Type, DataSecBTFType>) {
+            return type.variable_list.size();
+
+          } else {
+            return 0;
+          }
+        },
+        btf_type);
+
+    capacity.add(IBTF::getBTFTypeKind(btf_type), record_count);
+  }
+
+  reserve(capacity);
+
+  for (auto &btf_type : btf_type_list) {
+    slice_list.push_back(moveRecords(btf_type));
+  }
+
+  btf_type_store = BTFTypeStore(first_id, std::move(btf_type_list));
+}
+
+BTFTypeTable::BTFTypeTable(BTFTypeStore btf_type_store_)
+    : btf_type_store(btf_type_store_.firstId()) {
+
+  for (auto id = btf_type_store_.firstId(); id < btf_type_store_.endId();
+       ++id) {
+    auto btf_type = btf_type_store_.get(id);
+    if (btf_type != nullptr) {
+      insert(id, std::move(*btf_type));
+    }
+  }
+}
+
+void BTFTypeTable::Capacity::add(BTFKind kind,
+                                 std::size_t record_count) noexcept {
+  ++type_count;
+
+  switch (kind) {
+  case BTFKind::Struct:
+  case BTFKind::Union:
+    member_count += record_count;
+    break;
+
+  case BTFKind::FuncProto:
+    param_count += record_count;
+    break;
+
+  case BTFKind::Enum:
+    value_count += record_count;
+    break;
+
+  case BTFKind::DataSec:
+    variable_count += record_count;
+    break;
+
+  default:
+    break;
+  }
+}
+
+void BTFTypeTable::reserve(const Capacity &capacity) {
+  auto end_id = static_cast<std::size_t>(endId()) + capacity.type_count;
+  btf_type_store.reserve(static_cast<std::uint32_t>(end_id));
+  slice_list.reserve(end_id - firstId());
+
+  reserveRecords(capacity.member_count, member_arrays.name_list,
+                 member_arrays.type_list, member_arrays.offset_list,
+                 member_arrays.bitfield_size_list);
+
+  reserveRecords(capacity.param_count, param_arrays.name_list,
+                 param_arrays.type_list);
+
+  reserveRecords(capacity.value_count, value_arrays.name_list,
+                 value_arrays.val_list);
+
+  reserveRecords(capacity.variable_count, variable_arrays.type_list,
+                 variable_arrays.offset_list, variable_arrays.size_list);
+}
+
+void BTFTypeTable::insert(std::uint32_t id, BTFType btf_type) {
+  if (id < firstId()) {
+    throw std::out_of_range("Invalid type ID");
+  }
+
+  auto slice = moveRecords(btf_type);
+  btf_type_store.insert(id, std::move(btf_type));
+
+  auto index = static_cast<std::size_t>(id - firstId());
+  if (index >= slice_list.size()) {
+    slice_list.resize(static_cast<std::size_t>(endId() - firstId()));
+  }
+
+  slice_list[index] = slice;
+}
+
+std::optional<BTFType> BTFTypeTable::get(std::uint32_t id) const {
+  auto btf_type = btf_type_store.get(id);
+  if (btf_type == nullptr) {
+    return std::nullopt;
+  }
+
+  std::optional<BTFType> output(*btf_type);
+  copyRecords(output.value(), getSlice(id));
+
+  return output;
+}
+
+const BTFType *BTFTypeTable::assemble(std::uint32_t id,
+                                      AssemblyBuffer &buffer) const {
+  auto btf_type = btf_type_store.get(id);
+  if (btf_type == nullptr) {
+    return nullptr;
+  }
+
+  auto slice = getSlice(id);
+  if (slice.count == 0) {
+    return btf_type;
+  }
+
+  // The buffer slot already holds this kind after the first call, and the
+  // lists of the stored type are empty, so assigning it only clears them
+  auto &output = buffer[btf_type->index()];
+  output = *btf_type;
+  copyRecords(output, slice);
+
+  return &output;
+}
+
+BTFTypeTable::Slice BTFTypeTable::getSlice(std::uint32_t id) const noexcept {
+  if (id < firstId()) {
+    return Slice{};
+  }
+
+  auto index = static_cast<std::size_t>(id - firstId());
+  if (index >= slice_list.size()) {
+    return Slice{};
+  }
+
+  return slice_list[index];
+}
+
+BTFTypeMap BTFTypeTable::toMap() const {
+  BTFTypeMap btf_type_map;
+  btf_type_map.reserve(size());
+
+  for (auto id = firstId(); id < endId(); ++id) {
+    auto opt_btf_type = get(id);
+    if (opt_btf_type.has_value()) {
+      btf_type_map.insert({id, std::move(opt_btf_type.value())});
+    }
+  }
+
+  return btf_type_map;
+}
+
+BTFTypeTable::Slice BTFTypeTable::moveRecords(BTFType &btf_type) {
+  // The arrays are reserved before the first record is appended, so they
+  // always have the same size, even if an allocation fails
+  return std::visit(
+      [this](auto &type) -> Slice {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (kHasMemberList<Type>) {
+          auto &arrays = member_arrays;
+          growRecords(type.member_list.size(), arrays.name_list,
+                      arrays.type_list, arrays.offset_list,
+                      arrays.bitfield_size_list);
+
+          auto member_list = std::move(type.member_list);
+          auto slice = createSlice(arrays.type_list, member_list.size());
+
+          for (const auto &member : member_list) {
+            arrays.name_list.push_back(fromOptionalName(member.opt_name));
+            arrays.type_list.push_back(member.type);
+            arrays.offset_list.push_back(member.offset);
+            arrays.bitfield_size_list.push_back(member.opt_bitfield_size);
+          }
+
+          return slice;
+
+        } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+          auto &arrays = param_arrays;
+          growRecords(type.param_list.size(), arrays.name_list,
+                      arrays.type_list);
+
+          auto param_list = std::move(type.param_list);
+          auto slice = createSlice(arrays.type_list, param_list.size());
+
+          for (const auto &param : param_list) {
+            arrays.name_list.push_back(fromOptionalName(param.opt_name));
+            arrays.type_list.push_back(param.type);
+          }
+
+          return slice;
+
+        } else if constexpr (std::is_same_v<Type, EnumBTFType>) {
+          auto &arrays = value_arrays;
+          growRecords(type.value_list.size(), arrays.name_list,
+                      arrays.val_list);
+
+          auto value_list = std::move(type.value_list);
+          auto slice = createSlice(arrays.val_list, value_list.size());
+
+          for (const auto &value : value_list) {
+            arrays.name_list.push_back(value.name);
+            arrays.val_list.push_back(value.val);
+          }
+
+          return slice;
+
+        } else if constexpr (std::is_same_v<Type, DataSecBTFType>) {
+          auto &arrays = variable_arrays;
+          growRecords(type.variable_list.size(), arrays.type_list,
+                      arrays.offset_list, arrays.size_list);
+
+          auto variable_list = std::move(type.variable_list);
+          auto slice = createSlice(arrays.type_list, variable_list.size());
+
+          for (const auto &variable : variable_list) {
+            arrays.type_list.push_back(variable.type);
+            arrays.offset_list.push_back(variable.offset);
+            arrays.size_list.push_back(variable.size);
+          }
+
+          return slice;
+
+        } else {
+          return Slice{};
+        }
+      },
+      btf_type);
+}
+
+void BTFTypeTable::copyRecords(BTFType &btf_type, const Slice &slice) const {
+  auto first_index = static_cast<std::size_t>(slice.start);
+  auto last_index = first_index + slice.count;
+
+  std::visit(
+      [&](auto &type) {
+        using Type = std::decay_t<decltype(type)>;
+
+        if constexpr (kHasMemberList<Type>) {
+          const auto &arrays = member_arrays;
+          type.member_list.reserve(slice.count);
+
+          for (auto index = first_index; index < last_index; ++index) {
+            typename Type::Member member;
+            member.opt_name = toOptionalName(arrays.name_list[index]);
+            member.type = arrays.type_list[index];
+            member.offset = arrays.offset_list[index];
+            member.opt_bitfield_size = arrays.bitfield_size_list[index];
+
+            type.member_list.push_back(std::move(member));
+          }
+
+        } else if constexpr (std::is_same_v<Type, FuncProtoBTFType>) {
+          const auto &arrays = param_arrays;
+          type.param_list.reserve(slice.count);
+
+          for (auto index = first_index; index < last_index; ++index) {
+            FuncProtoBTFType::Param param;
+            param.opt_name = toOptionalName(arrays.name_list[index]);
+            param.type = arrays.type_list[index];
+
+            type.param_list.push_back(std::move(param));
+          }
+
+        } else if constexpr (std::is_same_v<Type, EnumBTFType>) {
+          const auto &arrays = value_arrays;
+          type.value_list.reserve(slice.count);
+
+          for (auto index = first_index; index < last_index; ++index) {
+            EnumBTFType::Value value;
+            value.name = arrays.name_list[index];
+            value.val = arrays.val_list[index];
+
+            type.value_list.push_back(std::move(value));
+          }
+
+        } else if constexpr (std::is_same_v<Type, DataSecBTFType>) {
+          const auto &arrays = variable_arrays;
+          type.variable_list.reserve(slice.count);
+
+          for (auto index = first_index; index < last_index; ++index) {
+            DataSecBTFType::Variable variable;
+            variable.type = arrays.type_list[index];
+            variable.offset = arrays.offset_list[index];
+            variable.size = arrays.size_list[index];
+
+            type.variable_list.push_back(std::move(variable));
+          }
+        }
+      },
+      btf_type);
+}
+
+} // namespace btfparse
@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include "btftypestore.h"
+
+#include <btfparse/ibtf.h>
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace btfparse {
+
+// Types indexed by ID, with the variable-length records of all of them
+// (struct and union members, function parameters, enum values and DataSec
+// variables) moved out of the types and into a few shared arrays, one per
+// field. Each type refers to its records with a (start, count) slice, so
+// the records are read with a linear scan, and releasing the table frees a
+// fixed number of buffers rather than one list per type.
+//
+// The rest of each type is kept in a BTFTypeStore, where the lists are
+// always empty; get() puts them back. Replacing a type leaves its old
+// records unused. Methods that allocate throw std::bad_alloc
+class BTFTypeTable final {
+public:
+  // A range of records inside the arrays of the kind of the type
+  struct Slice final {
+    std::uint32_t start{};
+    std::uint32_t count{};
+  };
+
+  // Missing names are stored as a std::string_view without data
+  static std::optional<std::string_view>
+  toOptionalName(std::string_view name) noexcept {
+    if (name.data() == nullptr) {
+      return std::nullopt;
+    }
+
+    return name;
+  }
+
+  // Struct and union members
+  struct MemberArrays final {
+    std::vector<std::string_view> name_list;
+    std::vector<std::uint32_t> type_list;
+    std::vector<std::uint32_t> offset_list;
+    std::vector<std::optional<std::uint8_t>> bitfield_size_list;
+  };
+
+  // Function prototype parameters
+  struct ParamArrays final {
+    std::vector<std::string_view> name_list;
+    std::vector<std::uint32_t> type_list;
+  };
+
+  // Enum values
+  struct ValueArrays final {
+    std::vector<std::string_view> name_list;
+    std::vector<std::int32_t> val_list;
+  };
+
+  // DataSec variables
+  struct VariableArrays final {
+    std::vector<std::uint32_t> type_list;
+    std::vector<std::uint32_t> offset_list;
+    std::vector<std::uint32_t> size_list;
+  };
+
+  // The number of types and records that are about to be stored
+  struct Capacity final {
+    std::size_t type_count{};
+    std::size_t member_count{};
+    std::size_t param_count{};
+    std::size_t value_count{};
+    std::size_t variable_count{};
+
+    // Counts a type of the given kind, which has `record_count` records
+    void add(BTFKind kind, std::size_t record_count) noexcept;
+  };
+
+  BTFTypeTable(std::uint32_t first_id = 1U);
+
+  // Used by assemble(), which keeps one type of each kind in it, so that
+  // their lists are reused from one call to the next
+  using AssemblyBuffer = std::array<BTFType, std::variant_size_v<BTFType>>;
+
+  // Takes a list of types that start at `first_id`, in ID order
+  BTFTypeTable(std::uint32_t first_id, std::vector<BTFType> btf_type_list);
+
+  // Takes the types of a store
+  explicit BTFTypeTable(BTFTypeStore btf_type_store_);
+
+  std::uint32_t firstId() const noexcept { return btf_type_store.firstId(); }
+  std::uint32_t endId() const noexcept { return btf_type_store.endId(); }
+
+  std::uint32_t size() const noexcept { return btf_type_store.size(); }
+  bool empty() const noexcept { return btf_type_store.empty(); }
+
+  bool contains(std::uint32_t id) const noexcept {
+    return btf_type_store.contains(id);
+  }
+
+  std::optional<BTFKind> getKind(std::uint32_t id) const noexcept {
+    return btf_type_store.getKind(id);
+  }
+
+  // Makes room for the given number of types after the last slot, and for
+  // their records, so that the arrays are not moved while they are filled
+  void reserve(const Capacity &capacity);
+
+  // Stores the type with the given ID, replacing the existing one
+  void insert(std::uint32_t id, BTFType btf_type);
+
+  // Returns a copy of the type, lists included
+  std::optional<BTFType> get(std::uint32_t id) const;
+
+  // Same as above, but the type is put back together in the buffer, which
+  // stops allocating once its lists have grown; types without records are
+  // returned in place. The type remains valid until the buffer is used for
+  // another type of the same kind. nullptr if the type is not stored
+  const BTFType *assemble(std::uint32_t id, AssemblyBuffer &buffer) const;
+
+  // The stored type, without its lists; nullptr if it is not stored
+  const BTFType *getFixedPart(std::uint32_t id) const noexcept {
+    return btf_type_store.get(id);
+  }
+
+  // The records of the type; empty if it is not stored or has no list
+  Slice getSlice(std::uint32_t id) const noexcept;
+
+  const MemberArrays &memberArrays() const noexcept { return member_arrays; }
+  const ParamArrays &paramArrays() const noexcept { return param_arrays; }
+  const ValueArrays &valueArrays() const noexcept { return value_arrays; }
+
+  const VariableArrays &variableArrays() const noexcept {
+    return variable_arrays;
+  }
+
+  // Copies the stored types to a map
+  BTFTypeMap toMap() const;
+
+private:
+  BTFTypeStore btf_type_store;
+
+  // Indexed like the slots of the store
+  std::vector<Slice> slice_list;
+
+  MemberArrays member_arrays;
+  ParamArrays param_arrays;
+  ValueArrays value_arrays;
+  VariableArrays variable_arrays;
+
+  Slice moveRecords(BTFType &btf_type);
+  void copyRecords(BTFType &btf_type, const Slice &slice) const;
+};
+
+} // namespace btfparse
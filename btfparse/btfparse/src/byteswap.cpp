@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "byteswap.h"
+
+#include <cstring>
+
+#ifdef BTFPARSE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace btfparse {
+
+void byteSwap32Scalar(std::uint8_t *destination, const std::uint8_t *source,
+                      std::size_t word_count) noexcept {
+  for (std::size_t i = 0; i < word_count; ++i) {
+    std::uint32_t word;
+    std::memcpy(&word, source + (i * 4), sizeof(word));
+
+    word = __builtin_bswap32(word);
+    std::memcpy(destination + (i * 4), &word, sizeof(word));
+  }
+}
+
+#ifdef BTFPARSE_X86_SIMD
+__attribute__((target("ssse3"))) void
+byteSwap32SSSE3(std::uint8_t *destination, const std::uint8_t *source,
+                std::size_t word_count) noexcept {
+  const auto shuffle_mask =
+      _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+  std::size_t i{0};
+  for (; i + 4 <= word_count; i += 4) {
+    auto words =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + (i * 4)));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + (i * 4)),
+                     _mm_shuffle_epi8(words, shuffle_mask));
+  }
+
+  byteSwap32Scalar(destination + (i * 4), source + (i * 4), word_count - i);
+}
+
+__attribute__((target("avx2"))) void
+byteSwap32AVX2(std::uint8_t *destination, const std::uint8_t *source,
+               std::size_t word_count) noexcept {
+  const auto shuffle_mask = _mm256_setr_epi8(
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6,
+      5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+  std::size_t i{0};
+  for (; i + 8 <= word_count; i += 8) {
+    auto words = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(source + (i * 4)));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + (i * 4)),
+                        _mm256_shuffle_epi8(words, shuffle_mask));
+  }
+
+  byteSwap32SSSE3(destination + (i * 4), source + (i * 4), word_count - i);
+}
+#endif
+
+namespace {
+
+using ByteSwap32Function = void (*)(std::uint8_t *, const std::uint8_t *,
+                                    std::size_t);
+
+ByteSwap32Function selectByteSwap32Function() {
+#ifdef BTFPARSE_X86_SIMD
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2")) {
+    return byteSwap32AVX2;
+
+  } else if (__builtin_cpu_supports("ssse3")) {
+    return byteSwap32SSSE3;
+  }
+#endif
+
+  return byteSwap32Scalar;
+}
+
+} // namespace
+
+void byteSwap32(std::uint8_t *destination, const std::uint8_t *source,
+                std::size_t word_count) noexcept {
+  static const auto kByteSwap32Function{selectByteSwap32Function()};
+  kByteSwap32Function(destination, source, word_count);
+}
+
+} // namespace btfparse
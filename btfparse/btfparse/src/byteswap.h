@@ -0,0 +1,41 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BTFPARSE_X86_SIMD
+#endif
+
+namespace btfparse {
+
+// Reverses the byte order of `word_count` consecutive 32-bit words. The
+// source and destination buffers may be the same, but must not otherwise
+// overlap. Uses AVX2 or SSSE3 shuffles when the CPU supports them
+void byteSwap32(std::uint8_t *destination, const std::uint8_t *source,
+                std::size_t word_count) noexcept;
+
+// The implementations that byteSwap32() picks from, exposed for the tests.
+// The vector ones must only be called when the CPU supports them
+void byteSwap32Scalar(std::uint8_t *destination, const std::uint8_t *source,
+                      std::size_t word_count) noexcept;
+
+#ifdef BTFPARSE_X86_SIMD
+__attribute__((target("ssse3"))) void
+byteSwap32SSSE3(std::uint8_t *destination, const std::uint8_t *source,
+                std::size_t word_count) noexcept;
+
+__attribute__((target("avx2"))) void
+byteSwap32AVX2(std::uint8_t *destination, const std::uint8_t *source,
+               std::size_t word_count) noexcept;
+#endif
+
+} // namespace btfparse
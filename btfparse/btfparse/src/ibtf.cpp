@@ -7,29 +7,71 @@
 //
 
 #include "btf.h"
+#include "btfscanner.h"
 
 #include <btfparse/ibtf.h>
 
 namespace btfparse {
 
 Result<IBTF::Ptr, BTFError>
-IBTF::createFromPath(const std::filesystem::path &path) noexcept {
-  return IBTF::createFromPathList({path});
+IBTF::createFromPath(const std::filesystem::path &path,
+                     const BTFOptions &options) noexcept {
+  return IBTF::createFromPathList({path}, options);
 }
 
 Result<IBTF::Ptr, BTFError>
-IBTF::createFromPathList(const PathList &path_list) noexcept {
-  try {
-    return Ptr(new BTF(path_list));
+IBTF::createFromPathList(const PathList &path_list,
+                         const BTFOptions &options) noexcept {
+  auto btf_file_list_res = BTF::openPathList(path_list, options);
+  if (btf_file_list_res.failed()) {
+    return btf_file_list_res.takeError();
+  }
+
+  return BTF::create(btf_file_list_res.takeValue(), options);
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromBuffers(const BufferList &buffer_list,
+                        const BTFOptions &options) noexcept {
+  return createFromBuffers(buffer_list, nullptr, options);
+}
+
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromBuffers(const BufferList &buffer_list,
+                        std::shared_ptr<const void> owner,
+                        const BTFOptions &options) noexcept {
+  auto btf_file_list_res = BTF::openBufferList(buffer_list, owner);
+  if (btf_file_list_res.failed()) {
+    return btf_file_list_res.takeError();
+  }
 
-  } catch (const std::bad_alloc &) {
-    return BTFError(BTFErrorInformation{
-        BTFErrorInformation::Code::MemoryAllocationFailure,
-    });
+  return BTF::create(btf_file_list_res.takeValue(), options);
+}
 
-  } catch (const BTFError &e) {
-    return e;
+Result<IBTF::Ptr, BTFError>
+IBTF::createFromStream(IStream &stream, const BTFOptions &) noexcept {
+  return BTF::createFromStream(stream);
+}
+
+std::optional<BTFError> IBTF::scan(const PathList &path_list,
+                                   const BTFVisitor &visitor,
+                                   const BTFOptions &options) noexcept {
+  auto btf_file_list_res = BTF::openPathList(path_list, options);
+  if (btf_file_list_res.failed()) {
+    return btf_file_list_res.takeError();
   }
+
+  return BTFScanner::scan(btf_file_list_res.takeValue(), visitor);
+}
+
+std::optional<BTFError> IBTF::validate(const PathList &path_list,
+                                       const BTFOptions &options) noexcept {
+  auto btf_file_list_res = BTF::openPathList(path_list, options);
+  if (btf_file_list_res.failed()) {
+    return btf_file_list_res.takeError();
+  }
+
+  return BTF::validateTypeSections(btf_file_list_res.takeValue(), options);
 }
 
 BTFKind IBTF::getBTFTypeKind(const BTFType &btf_type) noexcept {
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace btfparse {
+
+class ThreadPool final {
+public:
+  // Upper bound used when the caller does not pick a thread count, sized
+  // for the 32-core hosts that parallel decoding targets
+  static constexpr std::size_t kDefaultMaxThreadCount{32U};
+
+  // Resolves a requested thread count, where zero means "automatic"
+  static std::size_t getThreadCount(std::size_t requested_thread_count,
+                                    std::size_t work_item_count) noexcept {
+    auto thread_count = requested_thread_count;
+    if (thread_count == 0) {
+      thread_count = std::min<std::size_t>(std::thread::hardware_concurrency(),
+                                           kDefaultMaxThreadCount);
+    }
+
+    return std::max<std::size_t>(1, std::min(thread_count, work_item_count));
+  }
+
+  // Calls `function(index)` for each index in [0, count), using at most
+  // `thread_count` threads (including the calling one). Indexes are
+  // handed out in order to whichever thread is idle. The function must
+  // not throw
+  template <typename Function>
+  static void forEachIndex(std::size_t count, std::size_t thread_count,
+                           const Function &function) noexcept {
+    std::atomic_size_t next_index{0};
+
+    auto worker = [&]() {
+      for (;;) {
+        auto index = next_index.fetch_add(1, std::memory_order_relaxed);
+        if (index >= count) {
+          break;
+        }
+
+        function(index);
+      }
+    };
+
+    std::vector<std::thread> thread_list;
+
+    try {
+      thread_list.reserve(thread_count);
+
+      for (std::size_t i = 1; i < std::min(thread_count, count); ++i) {
+        thread_list.emplace_back(worker);
+      }
+
+    } catch (const std::bad_alloc &) {
+      // Continue with the threads that have been started so far
+
+    } catch (const std::system_error &) {
+      // Same as above
+    }
+
+    worker();
+
+    for (auto &thread : thread_list) {
+      thread.join();
+    }
+  }
+
+  ThreadPool() = delete;
+};
+
+} // namespace btfparse
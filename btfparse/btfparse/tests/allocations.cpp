@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<std::size_t> allocation_count{0};
+
+} // namespace
+
+// Replaces the global allocation functions for the whole test binary; the
+// array and nothrow forms forward to these
+void *operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+  auto ptr = std::malloc(size != 0 ? size : 1);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace btfparse {
+
+namespace {
+
+// Upper bound on the number of allocations made for each decoded type: the
+// list of the variable-length record, which is released once its entries
+// have been moved to the shared arrays of the type table. Names point
+// inside the string section and are never copied, so they are made longer
+// than what fits in a small string buffer
+const std::size_t kMaxAllocationsPerType{1U};
+
+const std::string kNamePrefix{"long_name_prefix_"};
+
+const std::uint32_t kMemberCount{6U};
+
+std::vector<std::uint8_t> createBTF(std::uint32_t record_count,
+                                    bool little_endian) {
+  BTFBuilder builder(little_endian);
+
+  auto int_id = builder.addType("int", BTFKind::Int, 0, 4);
+  builder.addData(32U);
+
+  for (std::uint32_t i = 0; i < record_count; ++i) {
+    auto name = kNamePrefix + "t" + std::to_string(i);
+
+    builder.addType(name, BTFKind::Struct, kMemberCount, kMemberCount * 4);
+    for (std::uint32_t j = 0; j < kMemberCount; ++j) {
+      builder.addData(builder.addString(kNamePrefix + "m" + std::to_string(j)));
+      builder.addData(int_id);
+      builder.addData(j * 32U);
+    }
+
+    builder.addType(name, BTFKind::Enum, kMemberCount, 4);
+    for (std::uint32_t j = 0; j < kMemberCount; ++j) {
+      builder.addData(builder.addString(kNamePrefix + "v" + std::to_string(j)));
+      builder.addData(j);
+    }
+
+    builder.addType("", BTFKind::FuncProto, kMemberCount, int_id);
+    for (std::uint32_t j = 0; j < kMemberCount; ++j) {
+      builder.addData(builder.addString(kNamePrefix + "p" + std::to_string(j)));
+      builder.addData(int_id);
+    }
+  }
+
+  return builder.build();
+}
+
+std::size_t countAllocations(const std::vector<std::uint8_t> &blob,
+                             const BTFOptions &options) {
+  auto start_count = allocation_count.load();
+
+  {
+    auto btf_res =
+        IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())}, options);
+
+    REQUIRE(!btf_res.failed());
+  }
+
+  return allocation_count.load() - start_count;
+}
+
+} // namespace
+
+TEST_CASE("IBTF::createFromBuffers() allocations") {
+  // The fixed costs are the same for both inputs, so the difference only
+  // counts the allocations that grow with the number of types
+  const std::uint32_t kRecordCount{500U};
+
+  BTFOptions options;
+  options.thread_count = 1;
+
+  for (auto little_endian : {true, false}) {
+    auto small_blob = createBTF(kRecordCount, little_endian);
+    auto large_blob = createBTF(kRecordCount * 2, little_endian);
+
+    auto small_count = countAllocations(small_blob, options);
+    auto large_count = countAllocations(large_blob, options);
+
+    REQUIRE(large_count > small_count);
+
+    auto type_count = static_cast<std::size_t>(kRecordCount) * 3U;
+
+    // Rounded down, as the type table also reallocates its arrays a few
+    // times while it grows
+    auto allocations_per_type = (large_count - small_count) / type_count;
+    CHECK(allocations_per_type <= kMaxAllocationsPerType);
+  }
+}
+
+} // namespace btfparse
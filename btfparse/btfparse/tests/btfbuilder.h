@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/ibtf.h>
+
+#include <string>
+#include <vector>
+
+namespace btfparse {
+
+// Assembles BTF blobs for the tests. Split BTF is created by passing the
+// base builder, so that type IDs and string offsets continue from it
+class BTFBuilder final {
+  bool little_endian{true};
+
+  std::uint32_t string_base{0};
+  std::uint32_t last_type_id{0};
+
+  std::vector<std::uint8_t> type_section;
+  std::vector<std::uint8_t> string_section;
+
+public:
+  BTFBuilder(bool little_endian_ = true) : little_endian(little_endian_) {
+    string_section.push_back(0);
+  }
+
+  BTFBuilder(const BTFBuilder &base, bool little_endian_ = true)
+      : little_endian(little_endian_),
+        string_base(base.string_base +
+                    static_cast<std::uint32_t>(base.string_section.size())),
+        last_type_id(base.last_type_id) {}
+
+  std::uint32_t addString(const std::string &str) {
+    auto offset =
+        string_base + static_cast<std::uint32_t>(string_section.size());
+
+    string_section.insert(string_section.end(), str.begin(), str.end());
+    string_section.push_back(0);
+
+    return offset;
+  }
+
+  std::uint32_t addType(const std::string &name, BTFKind kind,
+                        std::uint32_t vlen, std::uint32_t size_or_type,
+                        bool kind_flag = false) {
+
+    auto name_off = name.empty() ? 0U : addString(name);
+    auto info = (static_cast<std::uint32_t>(kind) << 24) | (vlen & 0xFFFFU) |
+                (kind_flag ? 0x80000000U : 0U);
+
+    addData(name_off);
+    addData(info);
+    addData(size_or_type);
+
+    return ++last_type_id;
+  }
+
+  void addData(std::uint32_t value) { addU32(type_section, value); }
+
+  std::vector<std::uint8_t> build() const {
+    std::vector<std::uint8_t> output;
+
+    auto type_len = static_cast<std::uint32_t>(type_section.size());
+    auto str_len = static_cast<std::uint32_t>(string_section.size());
+
+    addU16(output, 0xEB9F);
+    output.push_back(1);
+    output.push_back(0);
+    addU32(output, 24);
+    addU32(output, 0);
+    addU32(output, type_len);
+    addU32(output, type_len);
+    addU32(output, str_len);
+
+    output.insert(output.end(), type_section.begin(), type_section.end());
+    output.insert(output.end(), string_section.begin(), string_section.end());
+
+    return output;
+  }
+
+private:
+  void addU16(std::vector<std::uint8_t> &buffer, std::uint16_t value) const {
+    std::uint8_t low = static_cast<std::uint8_t>(value);
+    std::uint8_t high = static_cast<std::uint8_t>(value >> 8);
+
+    buffer.push_back(little_endian ? low : high);
+    buffer.push_back(little_endian ? high : low);
+  }
+
+  void addU32(std::vector<std::uint8_t> &buffer, std::uint32_t value) const {
+    auto low = static_cast<std::uint16_t>(value);
+    auto high = static_cast<std::uint16_t>(value >> 16);
+
+    addU16(buffer, little_endian ? low : high);
+    addU16(buffer, little_endian ? high : low);
+  }
+};
+
+} // namespace btfparse
@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btftypestore.h"
+
+#include <doctest/doctest.h>
+
+namespace btfparse {
+
+TEST_CASE("BTFTypeStore") {
+  // Split BTF files start from the type ID that follows the base
+  BTFTypeStore btf_type_store(10U);
+  CHECK(btf_type_store.empty());
+  CHECK(btf_type_store.endId() == 10U);
+
+  TypedefBTFType typedef_type;
+  typedef_type.name = "point_t";
+  typedef_type.type = 2;
+
+  btf_type_store.insert(10U, PtrBTFType{2});
+  btf_type_store.insert(13U, typedef_type);
+
+  CHECK(btf_type_store.size() == 2U);
+  CHECK(btf_type_store.endId() == 14U);
+
+  // The slots in between are empty
+  CHECK(btf_type_store.getKind(10U) == BTFKind::Ptr);
+  CHECK(!btf_type_store.getKind(11U).has_value());
+  CHECK(btf_type_store.getKind(13U) == BTFKind::Typedef);
+  CHECK(!btf_type_store.getKind(9U).has_value());
+  CHECK(!btf_type_store.getKind(14U).has_value());
+
+  CHECK(btf_type_store.get(12U) == nullptr);
+  REQUIRE(btf_type_store.get(13U) != nullptr);
+  CHECK(std::get<TypedefBTFType>(*btf_type_store.get(13U)).name == "point_t");
+
+  // Replacing a type does not change the count
+  btf_type_store.insert(10U, ConstBTFType{13});
+  CHECK(btf_type_store.size() == 2U);
+  CHECK(btf_type_store.getKind(10U) == BTFKind::Const);
+
+  auto btf_type_map = btf_type_store.toMap();
+  REQUIRE(btf_type_map.size() == 2U);
+  CHECK(btf_type_map.count(10U) == 1U);
+  CHECK(btf_type_map.count(13U) == 1U);
+
+  BTFTypeStore list_store(1U, {IntBTFType{}, BTFType{}, FloatBTFType{}});
+  CHECK(list_store.size() == 2U);
+  CHECK(list_store.getKind(1U) == BTFKind::Int);
+  CHECK(!list_store.contains(2U));
+  CHECK(list_store.getKind(3U) == BTFKind::Float);
+}
+
+} // namespace btfparse
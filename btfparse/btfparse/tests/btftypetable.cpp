@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btftypetable.h"
+
+#include <doctest/doctest.h>
+
+namespace btfparse {
+
+TEST_CASE("BTFTypeTable") {
+  StructBTFType struct_type;
+  struct_type.opt_name = "point";
+  struct_type.size = 12;
+
+  // The first member is anonymous
+  struct_type.member_list.push_back({std::nullopt, 1, 0, std::nullopt});
+  struct_type.member_list.push_back({"x", 1, 32, 3});
+  struct_type.member_list.push_back({"y", 1, 64, std::nullopt});
+
+  FuncProtoBTFType func_proto_type;
+  func_proto_type.return_type = 1;
+  func_proto_type.param_list.push_back({"argc", 1});
+  func_proto_type.param_list.push_back({std::nullopt, 0});
+
+  EnumBTFType enum_type;
+  enum_type.size = 4;
+  enum_type.value_list.push_back({"A", -1});
+
+  BTFTypeTable btf_type_table(1U, {IntBTFType{}, struct_type, BTFType{},
+                                   func_proto_type, enum_type});
+
+  CHECK(btf_type_table.size() == 4U);
+  CHECK(!btf_type_table.contains(3U));
+  CHECK(btf_type_table.getKind(2U) == BTFKind::Struct);
+
+  // Each type refers to a slice of the shared arrays
+  CHECK(btf_type_table.memberArrays().type_list.size() == 3U);
+  CHECK(btf_type_table.paramArrays().type_list.size() == 2U);
+  CHECK(btf_type_table.valueArrays().val_list.size() == 1U);
+  CHECK(btf_type_table.getSlice(2U).count == 3U);
+  CHECK(btf_type_table.getSlice(1U).count == 0U);
+
+  // Types appended later use the records that follow
+  btf_type_table.insert(6U, struct_type);
+  CHECK(btf_type_table.getSlice(6U).start == 3U);
+  CHECK(btf_type_table.memberArrays().type_list.size() == 6U);
+
+  // get() puts the lists back together
+  auto opt_btf_type = btf_type_table.get(6U);
+  REQUIRE(opt_btf_type.has_value());
+
+  const auto &output_struct = std::get<StructBTFType>(opt_btf_type.value());
+  CHECK(output_struct.opt_name == struct_type.opt_name);
+  REQUIRE(output_struct.member_list.size() == 3U);
+
+  for (std::size_t i = 0; i < output_struct.member_list.size(); ++i) {
+    const auto &member = output_struct.member_list[i];
+    const auto &expected_member = struct_type.member_list[i];
+
+    CHECK(member.opt_name == expected_member.opt_name);
+    CHECK(member.type == expected_member.type);
+    CHECK(member.offset == expected_member.offset);
+    CHECK(member.opt_bitfield_size == expected_member.opt_bitfield_size);
+  }
+
+  opt_btf_type = btf_type_table.get(4U);
+  REQUIRE(opt_btf_type.has_value());
+
+  const auto &output_func_proto =
+      std::get<FuncProtoBTFType>(opt_btf_type.value());
+
+  REQUIRE(output_func_proto.param_list.size() == 2U);
+  CHECK(output_func_proto.param_list[0].opt_name == "argc");
+  CHECK(!output_func_proto.param_list[1].opt_name.has_value());
+
+  // assemble() reuses the buffer, and returns types without lists in place
+  BTFTypeTable::AssemblyBuffer buffer;
+  CHECK(btf_type_table.assemble(1U, buffer) ==
+        btf_type_table.getFixedPart(1U));
+
+  CHECK(btf_type_table.assemble(3U, buffer) == nullptr);
+
+  auto assembled_type = btf_type_table.assemble(2U, buffer);
+  REQUIRE(assembled_type != nullptr);
+  CHECK(std::get<StructBTFType>(*assembled_type).member_list.size() == 3U);
+
+  // Types of the same kind share a slot
+  CHECK(btf_type_table.assemble(6U, buffer) == assembled_type);
+
+  const auto &member_list =
+      std::get<StructBTFType>(*assembled_type).member_list;
+
+  REQUIRE(member_list.size() == 3U);
+  CHECK(member_list[1].opt_name == "x");
+  CHECK(member_list[1].opt_bitfield_size == 3U);
+
+  auto btf_type_map = btf_type_table.toMap();
+  REQUIRE(btf_type_map.size() == 5U);
+  CHECK(std::get<EnumBTFType>(btf_type_map.at(5U)).value_list[0].val == -1);
+
+  // Split BTF files start from the type ID that follows the base
+  BTFTypeStore btf_type_store(10U);
+  btf_type_store.insert(11U, struct_type);
+
+  BTFTypeTable split_table(std::move(btf_type_store));
+  CHECK(split_table.firstId() == 10U);
+  CHECK(!split_table.contains(10U));
+  CHECK(split_table.getSlice(11U).count == 3U);
+}
+
+} // namespace btfparse
@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "byteswap.h"
+
+#include <doctest/doctest.h>
+
+#include <vector>
+
+namespace btfparse {
+
+TEST_CASE("byteSwap32()") {
+  // Covers the vector loops, their scalar tails and unaligned buffers
+  for (std::size_t word_count = 0; word_count < 40; ++word_count) {
+    for (std::size_t alignment = 0; alignment < 4; ++alignment) {
+      std::vector<std::uint8_t> source(alignment + (word_count * 4));
+      for (std::size_t i = 0; i < source.size(); ++i) {
+        source[i] = static_cast<std::uint8_t>((i * 7) + 1);
+      }
+
+      std::vector<std::uint8_t> expected(source);
+      for (std::size_t i = 0; i < word_count; ++i) {
+        auto word = expected.data() + alignment + (i * 4);
+        std::swap(word[0], word[3]);
+        std::swap(word[1], word[2]);
+      }
+
+      std::vector<std::uint8_t> destination(source.size());
+      std::copy(source.begin(),
+                source.begin() + static_cast<std::ptrdiff_t>(alignment),
+                destination.begin());
+
+      byteSwap32(destination.data() + alignment, source.data() + alignment,
+                 word_count);
+
+      CHECK(destination == expected);
+
+      byteSwap32(source.data() + alignment, source.data() + alignment,
+                 word_count);
+
+      CHECK(source == expected);
+    }
+  }
+}
+
+TEST_CASE("byteSwap32() implementations") {
+  using ByteSwap32Function = void (*)(std::uint8_t *, const std::uint8_t *,
+                                      std::size_t);
+
+  // Only the implementations that can run on this CPU are tested
+  std::vector<ByteSwap32Function> function_list;
+
+#ifdef BTFPARSE_X86_SIMD
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("ssse3")) {
+    function_list.push_back(byteSwap32SSSE3);
+  }
+
+  if (__builtin_cpu_supports("avx2")) {
+    function_list.push_back(byteSwap32AVX2);
+  }
+#endif
+
+  for (auto function : function_list) {
+    for (std::size_t word_count = 0; word_count < 40; ++word_count) {
+      for (std::size_t alignment = 0; alignment < 4; ++alignment) {
+        std::vector<std::uint8_t> source(alignment + (word_count * 4));
+        for (std::size_t i = 0; i < source.size(); ++i) {
+          source[i] = static_cast<std::uint8_t>((i * 7) + 1);
+        }
+
+        std::vector<std::uint8_t> expected(source);
+        byteSwap32Scalar(expected.data() + alignment,
+                         source.data() + alignment, word_count);
+
+        std::vector<std::uint8_t> destination(source);
+        function(destination.data() + alignment, source.data() + alignment,
+                 word_count);
+
+        CHECK(destination == expected);
+
+        function(source.data() + alignment, source.data() + alignment,
+                 word_count);
+
+        CHECK(source == expected);
+      }
+    }
+  }
+}
+
+} // namespace btfparse
@@ -0,0 +1,1068 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "btfbuilder.h"
+
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <fstream>
+
+namespace btfparse {
+
+namespace {
+
+BTFBuilder createBaseBTF(bool little_endian) {
+  BTFBuilder builder(little_endian);
+
+  builder.addType("int", BTFKind::Int, 0, 4);
+  builder.addData((1U << 24) | 32U);
+
+  builder.addType("point", BTFKind::Struct, 2, 8);
+  builder.addData(builder.addString("x"));
+  builder.addData(1);
+  builder.addData(0);
+  builder.addData(builder.addString("y"));
+  builder.addData(1);
+  builder.addData(32);
+
+  return builder;
+}
+
+BTFBuilder createSplitBTF(const BTFBuilder &base, bool little_endian) {
+  BTFBuilder builder(base, little_endian);
+  builder.addType("", BTFKind::Ptr, 0, 2);
+  builder.addType("point_t", BTFKind::Typedef, 0, 2);
+
+  return builder;
+}
+
+std::filesystem::path
+writeTemporaryFile(const std::string &name,
+                   const std::vector<std::uint8_t> &blob) {
+  auto path = std::filesystem::temp_directory_path() / name;
+
+  std::ofstream output(path, std::ios::binary | std::ios::trunc);
+  output.write(reinterpret_cast<const char *>(blob.data()),
+               static_cast<std::streamsize>(blob.size()));
+
+  return path;
+}
+
+// Stream that can only be read front to back, like a pipe
+class SequentialStream final : public IStream {
+  std::vector<std::uint8_t> buffer;
+  std::size_t buffer_pos{0};
+
+public:
+  SequentialStream(std::vector<std::uint8_t> buffer_)
+      : buffer(std::move(buffer_)) {}
+
+  virtual ~SequentialStream() override = default;
+
+  virtual bool seek(std::uint64_t offset) override {
+    return offset == buffer_pos;
+  }
+
+  virtual std::uint64_t offset() const override { return buffer_pos; }
+
+  virtual bool read(std::uint8_t *output, std::size_t size) override {
+    if (size > buffer.size() - buffer_pos) {
+      return false;
+    }
+
+    std::copy_n(buffer.begin() + static_cast<std::ptrdiff_t>(buffer_pos),
+                size, output);
+
+    buffer_pos += size;
+    return true;
+  }
+};
+
+void checkTypes(const IBTF &btf) {
+  REQUIRE(btf.count() == 4);
+
+  CHECK(btf.getKind(1) == BTFKind::Int);
+  CHECK(btf.getKind(3) == BTFKind::Ptr);
+  CHECK(!btf.getKind(5).has_value());
+
+  auto opt_struct = btf.getType(2);
+  REQUIRE(opt_struct.has_value());
+
+  const auto &struct_type = std::get<StructBTFType>(opt_struct.value());
+  CHECK(struct_type.opt_name == "point");
+  REQUIRE(struct_type.member_list.size() == 2);
+  CHECK(struct_type.member_list[1].opt_name == "y");
+  CHECK(struct_type.member_list[1].offset == 32);
+
+  auto opt_typedef = btf.getType(4);
+  REQUIRE(opt_typedef.has_value());
+
+  const auto &typedef_type = std::get<TypedefBTFType>(opt_typedef.value());
+  CHECK(typedef_type.name == "point_t");
+  CHECK(typedef_type.type == 2);
+}
+
+} // namespace
+
+TEST_CASE("IBTF::createFromBuffers()") {
+  for (auto little_endian : {true, false}) {
+    auto base = createBaseBTF(little_endian);
+
+    auto base_blob = base.build();
+    auto split_blob = createSplitBTF(base, little_endian).build();
+
+    auto btf_res = IBTF::createFromBuffers({
+        ByteSpan(base_blob.data(), base_blob.size()),
+        ByteSpan(split_blob.data(), split_blob.size()),
+    });
+
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+    checkTypes(*btf);
+
+    // Names are not copied, and point inside the string section
+    auto opt_struct = btf->getType(2);
+    REQUIRE(opt_struct.has_value());
+
+    const auto &struct_name =
+        std::get<StructBTFType>(opt_struct.value()).opt_name.value();
+
+    auto name_data = reinterpret_cast<const std::uint8_t *>(struct_name.data());
+    CHECK(name_data >= base_blob.data());
+    CHECK(name_data < base_blob.data() + base_blob.size());
+
+    BTFOptions options;
+    options.byte_swap_type_sections = false;
+
+    auto shared_blob =
+        std::make_shared<std::vector<std::uint8_t>>(std::move(base_blob));
+
+    btf_res = IBTF::createFromBuffers(
+        {
+            ByteSpan(shared_blob->data(), shared_blob->size()),
+            ByteSpan(split_blob.data(), split_blob.size()),
+        },
+        shared_blob, options);
+
+    REQUIRE(!btf_res.failed());
+    checkTypes(*btf_res.takeValue());
+  }
+}
+
+TEST_CASE("IBTF::createFromBuffers() with invalid data") {
+  auto blob = createBaseBTF(true).build();
+  blob[0] = 0;
+
+  auto btf_res = IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())});
+  REQUIRE(btf_res.failed());
+  CHECK(btf_res.error().get().code ==
+        BTFErrorInformation::Code::InvalidMagicValue);
+
+  blob = createBaseBTF(true).build();
+  blob.resize(blob.size() - 20);
+
+  btf_res = IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())});
+  CHECK(btf_res.failed());
+}
+
+TEST_CASE("IBTF::createFromBuffers() with multiple threads") {
+  // Enough records to be split across several decoding tasks
+  const std::uint32_t kTypedefCount{20000U};
+
+  for (auto little_endian : {true, false}) {
+    auto builder = createBaseBTF(little_endian);
+
+    for (std::uint32_t i = 0; i < kTypedefCount; ++i) {
+      builder.addType("t" + std::to_string(i), BTFKind::Typedef, 0, 2);
+    }
+
+    auto blob = builder.build();
+
+    BTFOptions options;
+    options.thread_count = 4;
+
+    auto btf_res =
+        IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())}, options);
+
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+    REQUIRE(btf->count() == kTypedefCount + 2);
+
+    for (std::uint32_t id = 3; id <= btf->count(); ++id) {
+      auto opt_typedef = btf->getType(id);
+      REQUIRE(opt_typedef.has_value());
+
+      const auto &typedef_type = std::get<TypedefBTFType>(opt_typedef.value());
+      REQUIRE(typedef_type.name == "t" + std::to_string(id - 3));
+    }
+  }
+
+  // The error must be the one for the lowest invalid type ID, as reported
+  // by the serial path
+  auto builder = createBaseBTF(true);
+
+  for (std::uint32_t i = 0; i < kTypedefCount; ++i) {
+    builder.addType("t", BTFKind::Typedef, 0, 2);
+  }
+
+  auto blob = builder.build();
+
+  for (std::size_t type_index : {15000U, 6000U}) {
+    // Point the name of the typedef past the end of the string section
+    auto name_offset = 24U + 16U + 36U + type_index * 12U;
+    blob[name_offset] = 0xFF;
+    blob[name_offset + 1] = 0xFF;
+  }
+
+  std::optional<BTFErrorInformation> opt_serial_error;
+
+  for (std::size_t thread_count : {1U, 4U}) {
+    BTFOptions options;
+    options.thread_count = thread_count;
+
+    auto btf_res =
+        IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())}, options);
+
+    REQUIRE(btf_res.failed());
+
+    const auto &error = btf_res.error().get();
+    CHECK(error.code == BTFErrorInformation::Code::InvalidStringOffset);
+    REQUIRE(error.opt_file_range.has_value());
+
+    if (!opt_serial_error.has_value()) {
+      opt_serial_error = error;
+      continue;
+    }
+
+    CHECK(error.opt_file_range->offset ==
+          opt_serial_error->opt_file_range->offset);
+  }
+}
+
+TEST_CASE("IBTF::createFromBuffers() with multiple split files") {
+  // Each split file continues from the one before it, and gets its own
+  // range of type IDs
+  const std::uint32_t kSplitFileCount{6U};
+  const std::uint32_t kTypedefCount{3000U};
+
+  std::vector<std::vector<std::uint8_t>> blob_list;
+
+  auto builder = createBaseBTF(true);
+  blob_list.push_back(builder.build());
+
+  for (std::uint32_t i = 0; i < kSplitFileCount; ++i) {
+    builder = BTFBuilder(builder, true);
+
+    for (std::uint32_t j = 0; j < kTypedefCount; ++j) {
+      builder.addType("s" + std::to_string(i), BTFKind::Typedef, 0, 2);
+    }
+
+    blob_list.push_back(builder.build());
+  }
+
+  BufferList buffer_list;
+  for (const auto &blob : blob_list) {
+    buffer_list.emplace_back(blob.data(), blob.size());
+  }
+
+  for (auto lazy : {false, true}) {
+    BTFOptions options;
+    options.thread_count = 4;
+    options.lazy = lazy;
+
+    auto btf_res = IBTF::createFromBuffers(buffer_list, options);
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+    REQUIRE(btf->count() == 2 + kSplitFileCount * kTypedefCount);
+
+    for (std::uint32_t i = 0; i < kSplitFileCount; ++i) {
+      auto first_id = 3 + i * kTypedefCount;
+
+      for (auto id : {first_id, first_id + kTypedefCount - 1}) {
+        auto opt_typedef = btf->getType(id);
+        REQUIRE(opt_typedef.has_value());
+
+        const auto &typedef_type =
+            std::get<TypedefBTFType>(opt_typedef.value());
+
+        CHECK(typedef_type.name == "s" + std::to_string(i));
+      }
+    }
+  }
+
+  // Errors are reported for the first invalid record, even when a later
+  // file fails the boundary scan: give the last typedef of the fifth file
+  // an invalid kind, and the second typedef of the second file a name
+  // offset that is out of bounds
+  auto &invalid_kind_blob = blob_list[5];
+  invalid_kind_blob[24 + (kTypedefCount - 1) * 12 + 7] = 30;
+
+  auto &invalid_name_blob = blob_list[2];
+  invalid_name_blob[24 + 12 + 2] = 0xFF;
+
+  BTFOptions options;
+  options.thread_count = 4;
+
+  auto btf_res = IBTF::createFromBuffers(buffer_list, options);
+  REQUIRE(btf_res.failed());
+  CHECK(btf_res.error().get().code ==
+        BTFErrorInformation::Code::InvalidStringOffset);
+
+  invalid_name_blob[24 + 12 + 2] = 0;
+
+  btf_res = IBTF::createFromBuffers(buffer_list, options);
+  REQUIRE(btf_res.failed());
+  CHECK(btf_res.error().get().code ==
+        BTFErrorInformation::Code::InvalidBTFKind);
+}
+
+TEST_CASE("IBTF::createFromBuffers() with an empty split string section") {
+  // A split file without strings starts at the same string offset as the
+  // one that follows it, which must still resolve its own names
+  for (auto little_endian : {true, false}) {
+    auto base = createBaseBTF(little_endian);
+
+    BTFBuilder empty_split(base, little_endian);
+    empty_split.addType("", BTFKind::Ptr, 0, 2);
+
+    BTFBuilder split(empty_split, little_endian);
+    split.addType("point_ptr_t", BTFKind::Typedef, 0, 3);
+
+    auto base_blob = base.build();
+    auto empty_split_blob = empty_split.build();
+    auto split_blob = split.build();
+
+    auto btf_res = IBTF::createFromBuffers({
+        ByteSpan(base_blob.data(), base_blob.size()),
+        ByteSpan(empty_split_blob.data(), empty_split_blob.size()),
+        ByteSpan(split_blob.data(), split_blob.size()),
+    });
+
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+    REQUIRE(btf->count() == 4);
+
+    auto opt_struct = btf->getType(2);
+    REQUIRE(opt_struct.has_value());
+    CHECK(std::get<StructBTFType>(opt_struct.value()).opt_name == "point");
+
+    auto opt_typedef = btf->getType(4);
+    REQUIRE(opt_typedef.has_value());
+    CHECK(std::get<TypedefBTFType>(opt_typedef.value()).name ==
+          "point_ptr_t");
+  }
+}
+
+TEST_CASE("IBTF::createFromBuffers() in lazy mode") {
+  for (auto little_endian : {true, false}) {
+    for (auto byte_swap_type_sections : {true, false}) {
+      auto base = createBaseBTF(little_endian);
+
+      auto base_blob = base.build();
+      auto split_blob = createSplitBTF(base, little_endian).build();
+
+      BTFOptions options;
+      options.lazy = true;
+      options.byte_swap_type_sections = byte_swap_type_sections;
+
+      auto btf_res = IBTF::createFromBuffers(
+          {
+              ByteSpan(base_blob.data(), base_blob.size()),
+              ByteSpan(split_blob.data(), split_blob.size()),
+          },
+          options);
+
+      REQUIRE(!btf_res.failed());
+
+      auto btf = btf_res.takeValue();
+      checkTypes(*btf);
+
+      // Types are cached after the first access
+      CHECK(btf->getType(2).has_value());
+      CHECK(!btf->getType(0).has_value());
+      CHECK(btf->getAll().size() == 4);
+    }
+  }
+
+  // Invalid kinds are detected while indexing
+  BTFBuilder builder;
+  builder.addType("", static_cast<BTFKind>(30), 0, 0);
+
+  auto blob = builder.build();
+
+  BTFOptions options;
+  options.lazy = true;
+
+  auto btf_res =
+      IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())}, options);
+
+  REQUIRE(btf_res.failed());
+  CHECK(btf_res.error().get().code ==
+        BTFErrorInformation::Code::InvalidBTFKind);
+}
+
+TEST_CASE("IBTF::getTypeOrError()") {
+  BTFBuilder builder;
+  builder.addType("int", BTFKind::Int, 0, 4);
+  builder.addData((1U << 24) | 32U);
+
+  // The size of an integer is only checked when the record is decoded
+  builder.addType("int24", BTFKind::Int, 0, 3);
+  builder.addData(24U);
+
+  auto blob = builder.build();
+
+  BTFOptions options;
+  options.lazy = true;
+
+  auto btf_res =
+      IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())}, options);
+
+  REQUIRE(!btf_res.failed());
+
+  auto btf = btf_res.takeValue();
+  CHECK(btf->count() == 2);
+
+  auto opt_int_res = btf->getTypeOrError(1);
+  REQUIRE(!opt_int_res.failed());
+  CHECK(opt_int_res.takeValue().has_value());
+
+  auto opt_missing_res = btf->getTypeOrError(3);
+  REQUIRE(!opt_missing_res.failed());
+  CHECK(!opt_missing_res.takeValue().has_value());
+
+  // The corrupt record is reported as an error, rather than as a missing type
+  auto opt_int24_res = btf->getTypeOrError(2);
+  REQUIRE(opt_int24_res.failed());
+  CHECK(opt_int24_res.error().get().code ==
+        BTFErrorInformation::Code::InvalidIntBTFTypeEncoding);
+
+  CHECK(!btf->getType(2).has_value());
+  CHECK(btf->getAll().size() == 1);
+
+  std::size_t visited_type_count{};
+  auto opt_error = btf->forEach([&](std::uint32_t, const BTFType &) -> bool {
+    ++visited_type_count;
+    return true;
+  });
+
+  REQUIRE(opt_error.has_value());
+  CHECK(opt_error.value().get().code ==
+        BTFErrorInformation::Code::InvalidIntBTFTypeEncoding);
+
+  CHECK(visited_type_count == 1);
+
+  opt_error = btf->forEachOfKind(
+      BTFKind::Int,
+      [](std::uint32_t, const BTFType &) -> bool { return true; });
+
+  CHECK(opt_error.has_value());
+
+  // Without the lazy mode, the same input is rejected upfront
+  btf_res = IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())});
+  CHECK(btf_res.failed());
+}
+
+TEST_CASE("IBTF::getTypeRef()") {
+  auto base = createBaseBTF(true);
+
+  auto base_blob = base.build();
+  auto split_blob = createSplitBTF(base, true).build();
+
+  BufferList buffer_list{
+      ByteSpan(base_blob.data(), base_blob.size()),
+      ByteSpan(split_blob.data(), split_blob.size()),
+  };
+
+  auto btf_res = IBTF::createFromBuffers(buffer_list);
+  REQUIRE(!btf_res.failed());
+
+  auto btf = btf_res.takeValue();
+  CHECK(!btf->getTypeRef(0));
+  CHECK(!btf->getTypeRef(5));
+
+  auto int_ref = btf->getTypeRef(1);
+  REQUIRE(int_ref);
+  CHECK(int_ref.id() == 1);
+  CHECK(int_ref.kind() == BTFKind::Int);
+  CHECK(int_ref.name() == "int");
+  CHECK(int_ref.size() == 4U);
+  CHECK(!int_ref.type().has_value());
+  CHECK(!int_ref.asStruct().has_value());
+
+  auto ptr_ref = btf->getTypeRef(3);
+  REQUIRE(ptr_ref);
+  CHECK(!ptr_ref.name().has_value());
+  CHECK(ptr_ref.type() == 2U);
+
+  // Handles read the same data that getType() copies
+  auto opt_struct_ref = btf->getTypeRef(2).asStruct();
+  REQUIRE(opt_struct_ref.has_value());
+
+  auto struct_ref = opt_struct_ref.value();
+  CHECK(!struct_ref.isUnion());
+  CHECK(struct_ref.name() == "point");
+  CHECK(struct_ref.size() == 8U);
+
+  auto opt_struct = btf->getType(2);
+  REQUIRE(opt_struct.has_value());
+
+  const auto &member_list =
+      std::get<StructBTFType>(opt_struct.value()).member_list;
+
+  REQUIRE(struct_ref.memberCount() == member_list.size());
+
+  for (std::size_t i = 0; i < struct_ref.memberCount(); ++i) {
+    auto member_ref = struct_ref.member(i);
+
+    CHECK(member_ref.name() == member_list[i].opt_name);
+    CHECK(member_ref.type() == member_list[i].type);
+    CHECK(member_ref.offset() == member_list[i].offset);
+    CHECK(member_ref.bitfieldSize() == member_list[i].opt_bitfield_size);
+  }
+
+  // In lazy mode, handles remain valid while the other types are decoded
+  BTFBuilder builder;
+  builder.addType("int", BTFKind::Int, 0, 4);
+  builder.addData((1U << 24) | 32U);
+
+  for (std::uint32_t i = 0; i < 64; ++i) {
+    builder.addType("typedef_" + std::to_string(i), BTFKind::Typedef, 0, 1);
+  }
+
+  // A corrupt record, which is only decoded on first access
+  builder.addType("int24", BTFKind::Int, 0, 3);
+  builder.addData(24U);
+
+  auto blob = builder.build();
+
+  BTFOptions options;
+  options.lazy = true;
+
+  btf_res =
+      IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())}, options);
+
+  REQUIRE(!btf_res.failed());
+
+  btf = btf_res.takeValue();
+  CHECK(!btf->getTypeRef(0));
+  CHECK(!btf->getTypeRef(67));
+  CHECK(!btf->getTypeRef(66));
+
+  int_ref = btf->getTypeRef(1);
+  REQUIRE(int_ref);
+
+  std::vector<BTFTypeRef> typedef_ref_list;
+  for (std::uint32_t id = 2; id < 66; ++id) {
+    typedef_ref_list.push_back(btf->getTypeRef(id));
+  }
+
+  CHECK(int_ref.kind() == BTFKind::Int);
+  CHECK(int_ref.name() == "int");
+  CHECK(int_ref.size() == 4U);
+
+  for (std::size_t i = 0; i < typedef_ref_list.size(); ++i) {
+    const auto &typedef_ref = typedef_ref_list[i];
+    REQUIRE(typedef_ref);
+    CHECK(typedef_ref.kind() == BTFKind::Typedef);
+    CHECK(typedef_ref.name() == "typedef_" + std::to_string(i));
+    CHECK(typedef_ref.type() == 1U);
+  }
+}
+
+TEST_CASE("IBTF::forEach()") {
+  auto base = createBaseBTF(true);
+
+  auto base_blob = base.build();
+  auto split_blob = createSplitBTF(base, true).build();
+
+  BufferList buffer_list{
+      ByteSpan(base_blob.data(), base_blob.size()),
+      ByteSpan(split_blob.data(), split_blob.size()),
+  };
+
+  for (auto lazy : {false, true}) {
+    BTFOptions options;
+    options.lazy = lazy;
+
+    auto btf_res = IBTF::createFromBuffers(buffer_list, options);
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+
+    // Types are visited in ID order, lists included
+    std::vector<std::uint32_t> id_list;
+    std::size_t member_count{};
+
+    auto opt_error =
+        btf->forEach([&](std::uint32_t id, const BTFType &btf_type) -> bool {
+          CHECK(IBTF::getBTFTypeKind(btf_type) == btf->getKind(id));
+          id_list.push_back(id);
+
+          if (auto struct_type = std::get_if<StructBTFType>(&btf_type)) {
+            member_count += struct_type->member_list.size();
+          }
+
+          return true;
+        });
+
+    CHECK(!opt_error.has_value());
+    CHECK(id_list == std::vector<std::uint32_t>{1, 2, 3, 4});
+    CHECK(member_count == 2U);
+
+    // Returning false stops the iteration
+    id_list.clear();
+
+    opt_error = btf->forEach([&](std::uint32_t id, const BTFType &) -> bool {
+      id_list.push_back(id);
+      return id < 2;
+    });
+
+    CHECK(!opt_error.has_value());
+    CHECK(id_list == std::vector<std::uint32_t>{1, 2});
+
+    // Only the types of the requested kind are visited
+    id_list.clear();
+
+    opt_error = btf->forEachOfKind(
+        BTFKind::Typedef, [&](std::uint32_t id, const BTFType &btf_type) {
+          CHECK(std::get<TypedefBTFType>(btf_type).name == "point_t");
+          id_list.push_back(id);
+          return true;
+        });
+
+    CHECK(!opt_error.has_value());
+    CHECK(id_list == std::vector<std::uint32_t>{4});
+
+    opt_error = btf->forEachOfKind(
+        BTFKind::Float, [](std::uint32_t, const BTFType &) { return false; });
+
+    CHECK(!opt_error.has_value());
+  }
+}
+
+TEST_CASE("IBTF::createFromStream()") {
+  for (auto little_endian : {true, false}) {
+    auto builder = createBaseBTF(little_endian);
+
+    // Larger than the streaming buffer, so that the record has to be
+    // assembled from multiple reads
+    const std::uint32_t kMemberCount{6000U};
+    builder.addType("large", BTFKind::Struct, kMemberCount, kMemberCount * 4);
+
+    for (std::uint32_t i = 0; i < kMemberCount; ++i) {
+      builder.addData(i == kMemberCount - 1 ? builder.addString("last") : 0);
+      builder.addData(1);
+      builder.addData(i * 32);
+    }
+
+    builder.addType("large_t", BTFKind::Typedef, 0, 3);
+
+    SequentialStream stream(builder.build());
+
+    auto btf_res = IBTF::createFromStream(stream);
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+    REQUIRE(btf->count() == 4);
+
+    auto opt_struct = btf->getType(2);
+    REQUIRE(opt_struct.has_value());
+
+    const auto &point_type = std::get<StructBTFType>(opt_struct.value());
+    CHECK(point_type.opt_name == "point");
+    REQUIRE(point_type.member_list.size() == 2);
+    CHECK(point_type.member_list[1].opt_name == "y");
+
+    auto opt_large_struct = btf->getType(3);
+    REQUIRE(opt_large_struct.has_value());
+
+    const auto &large_type = std::get<StructBTFType>(opt_large_struct.value());
+    CHECK(large_type.opt_name == "large");
+    REQUIRE(large_type.member_list.size() == kMemberCount);
+    CHECK(!large_type.member_list[0].opt_name.has_value());
+    CHECK(large_type.member_list.back().opt_name == "last");
+    CHECK(large_type.member_list.back().offset == (kMemberCount - 1) * 32);
+
+    auto opt_typedef = btf->getType(4);
+    REQUIRE(opt_typedef.has_value());
+    CHECK(std::get<TypedefBTFType>(opt_typedef.value()).name == "large_t");
+  }
+}
+
+TEST_CASE("IBTF::createFromStream() with invalid data") {
+  auto blob = createBaseBTF(true).build();
+  blob.resize(blob.size() - 1);
+
+  SequentialStream truncated_stream(blob);
+
+  auto btf_res = IBTF::createFromStream(truncated_stream);
+  REQUIRE(btf_res.failed());
+  CHECK(btf_res.error().get().code == BTFErrorInformation::Code::IOError);
+
+  BTFBuilder builder;
+  builder.addType("", BTFKind::Typedef, 0, 0);
+  blob = builder.build();
+
+  // Point the name of the type past the end of the string section
+  blob[24] = 0x10;
+
+  SequentialStream invalid_stream(blob);
+
+  btf_res = IBTF::createFromStream(invalid_stream);
+  REQUIRE(btf_res.failed());
+  CHECK(btf_res.error().get().code ==
+        BTFErrorInformation::Code::InvalidStringOffset);
+}
+
+TEST_CASE("IBTF::createFromPathList()") {
+  auto base = createBaseBTF(true);
+
+  auto base_path = writeTemporaryFile("btfparse-tests-base", base.build());
+  auto split_path = writeTemporaryFile("btfparse-tests-split",
+                                       createSplitBTF(base, true).build());
+
+  auto invalid_blob = base.build();
+  invalid_blob[0] = 0;
+
+  auto invalid_path =
+      writeTemporaryFile("btfparse-tests-invalid", invalid_blob);
+
+  auto missing_path =
+      std::filesystem::temp_directory_path() / "btfparse-tests-missing";
+
+  for (std::size_t thread_count : {1U, 4U}) {
+    BTFOptions options;
+    options.thread_count = thread_count;
+
+    auto btf_res = IBTF::createFromPathList({base_path, split_path}, options);
+    REQUIRE(!btf_res.failed());
+    checkTypes(*btf_res.takeValue());
+
+    // Errors are reported for the first failing path in the caller's order,
+    // regardless of which file finishes loading first
+    btf_res = IBTF::createFromPathList(
+        {base_path, missing_path, invalid_path}, options);
+
+    REQUIRE(btf_res.failed());
+    CHECK(btf_res.error().get().code ==
+          BTFErrorInformation::Code::FileNotFound);
+
+    btf_res = IBTF::createFromPathList(
+        {base_path, invalid_path, missing_path}, options);
+
+    REQUIRE(btf_res.failed());
+    CHECK(btf_res.error().get().code ==
+          BTFErrorInformation::Code::InvalidMagicValue);
+  }
+
+  std::filesystem::remove(base_path);
+  std::filesystem::remove(split_path);
+  std::filesystem::remove(invalid_path);
+}
+
+TEST_CASE("IBTF::scan()") {
+  for (auto little_endian : {true, false}) {
+    auto base = createBaseBTF(little_endian);
+
+    auto base_path =
+        writeTemporaryFile("btfparse-tests-scan-base", base.build());
+
+    auto split_path =
+        writeTemporaryFile("btfparse-tests-scan-split",
+                           createSplitBTF(base, little_endian).build());
+
+    std::vector<std::uint32_t> id_list;
+    std::vector<BTFKind> kind_list;
+    std::vector<std::string> member_name_list;
+    std::string typedef_name;
+
+    auto opt_error = IBTF::scan(
+        {base_path, split_path},
+        [&](std::uint32_t id, const BTFTypeView &btf_type) -> bool {
+          id_list.push_back(id);
+          kind_list.push_back(static_cast<BTFKind>(btf_type.index()));
+
+          if (auto struct_type = std::get_if<StructBTFTypeView>(&btf_type)) {
+            CHECK(struct_type->opt_name == "point");
+            CHECK(struct_type->size == 8);
+
+            for (const auto &member : struct_type->member_list) {
+              member_name_list.emplace_back(member.opt_name.value());
+            }
+
+          } else if (auto typedef_type =
+                         std::get_if<TypedefBTFTypeView>(&btf_type)) {
+            typedef_name = typedef_type->name;
+            CHECK(typedef_type->type == 2);
+          }
+
+          return true;
+        });
+
+    REQUIRE(!opt_error.has_value());
+
+    CHECK(id_list == std::vector<std::uint32_t>{1, 2, 3, 4});
+    CHECK(kind_list == std::vector<BTFKind>{BTFKind::Int, BTFKind::Struct,
+                                            BTFKind::Ptr, BTFKind::Typedef});
+
+    CHECK(member_name_list == std::vector<std::string>{"x", "y"});
+    CHECK(typedef_name == "point_t");
+
+    // Returning false from the visitor stops the scan
+    std::size_t visit_count{0};
+
+    opt_error = IBTF::scan({base_path, split_path},
+                           [&](std::uint32_t, const BTFTypeView &) -> bool {
+                             ++visit_count;
+                             return visit_count < 2;
+                           });
+
+    REQUIRE(!opt_error.has_value());
+    CHECK(visit_count == 2);
+
+    std::filesystem::remove(base_path);
+    std::filesystem::remove(split_path);
+  }
+
+  BTFBuilder builder;
+  builder.addType("", BTFKind::Typedef, 0, 0);
+
+  auto blob = builder.build();
+
+  // Point the name of the type past the end of the string section
+  blob[24] = 0x10;
+
+  auto invalid_path = writeTemporaryFile("btfparse-tests-scan-invalid", blob);
+
+  auto opt_error = IBTF::scan(
+      {invalid_path}, [](std::uint32_t, const BTFTypeView &) { return true; });
+
+  REQUIRE(opt_error.has_value());
+  CHECK(opt_error->get().code ==
+        BTFErrorInformation::Code::InvalidStringOffset);
+
+  std::filesystem::remove(invalid_path);
+}
+
+TEST_CASE("IBTF::validate()") {
+  // Enough records to be split across several validation tasks
+  const std::uint32_t kTypedefCount{20000U};
+
+  for (auto little_endian : {true, false}) {
+    auto base = createBaseBTF(little_endian);
+
+    auto base_path =
+        writeTemporaryFile("btfparse-tests-validate-base", base.build());
+
+    auto split_path = writeTemporaryFile(
+        "btfparse-tests-validate-split",
+        createSplitBTF(base, little_endian).build());
+
+    CHECK(!IBTF::validate({base_path, split_path}).has_value());
+
+    auto builder = createBaseBTF(little_endian);
+    for (std::uint32_t i = 0; i < kTypedefCount; ++i) {
+      builder.addType("t" + std::to_string(i), BTFKind::Typedef, 0, 2);
+    }
+
+    auto path = writeTemporaryFile("btfparse-tests-validate", builder.build());
+
+    for (std::size_t thread_count : {1U, 4U}) {
+      BTFOptions options;
+      options.thread_count = thread_count;
+
+      CHECK(!IBTF::validate({path}, options).has_value());
+    }
+
+    // A reference to a type that does not exist, and an invalid encoding
+    // that comes after it
+    auto bad_reference_id = kTypedefCount + 10U;
+    builder.addType("", BTFKind::Ptr, 0, bad_reference_id);
+    builder.addType("", BTFKind::Typedef, 0, 2);
+
+    path = writeTemporaryFile("btfparse-tests-validate", builder.build());
+
+    for (std::size_t thread_count : {1U, 4U}) {
+      BTFOptions options;
+      options.thread_count = thread_count;
+
+      auto opt_error = IBTF::validate({path}, options);
+      REQUIRE(opt_error.has_value());
+
+      const auto &error = opt_error.value().get();
+      CHECK(error.code == BTFErrorInformation::Code::InvalidTypeReference);
+
+      REQUIRE(error.opt_file_range.has_value());
+      CHECK(error.opt_file_range.value().offset ==
+            24U + 16U + 36U + (kTypedefCount * 12U));
+    }
+
+    // Trusted input skips the encoding checks
+    auto blob = builder.build();
+
+    auto btf_res =
+        IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())});
+    REQUIRE(btf_res.failed());
+    CHECK(btf_res.error().get().code ==
+          BTFErrorInformation::Code::InvalidTypedefBTFTypeEncoding);
+
+    BTFOptions options;
+    options.trusted = true;
+
+    btf_res =
+        IBTF::createFromBuffers({ByteSpan(blob.data(), blob.size())}, options);
+
+    REQUIRE(!btf_res.failed());
+    CHECK(btf_res.takeValue()->count() == kTypedefCount + 4U);
+
+    std::filesystem::remove(base_path);
+    std::filesystem::remove(split_path);
+    std::filesystem::remove(path);
+  }
+}
+
+TEST_CASE("IBTF::attachSplit()") {
+  auto base = createBaseBTF(true);
+
+  auto base_path =
+      writeTemporaryFile("btfparse-tests-attach-base", base.build());
+  auto split_path = writeTemporaryFile("btfparse-tests-attach-split",
+                                       createSplitBTF(base, true).build());
+
+  // A second split file that shares the same base
+  BTFBuilder other_split(base, true);
+  other_split.addType("other", BTFKind::Typedef, 0, 1);
+
+  auto other_split_path =
+      writeTemporaryFile("btfparse-tests-attach-other", other_split.build());
+
+  for (auto lazy : {false, true}) {
+    BTFOptions options;
+    options.lazy = lazy;
+
+    auto btf_res = IBTF::createFromPath(base_path, options);
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+
+    auto split_handle_res = btf->attachSplit(split_path);
+    REQUIRE(!split_handle_res.failed());
+
+    auto other_split_handle_res = btf->attachSplit(other_split_path);
+    REQUIRE(!other_split_handle_res.failed());
+
+    auto split_handle = split_handle_res.takeValue();
+    auto other_split_handle = other_split_handle_res.takeValue();
+    CHECK(split_handle != other_split_handle);
+
+    // The base is not affected by the attached files
+    CHECK(btf->count() == 2);
+    CHECK(!btf->getType(3).has_value());
+
+    CHECK(btf->getAll(split_handle).size() == 2);
+
+    auto opt_struct = btf->getType(split_handle, 2);
+    REQUIRE(opt_struct.has_value());
+    CHECK(std::get<StructBTFType>(opt_struct.value()).opt_name == "point");
+
+    auto opt_typedef = btf->getType(split_handle, 4);
+    REQUIRE(opt_typedef.has_value());
+    CHECK(std::get<TypedefBTFType>(opt_typedef.value()).name == "point_t");
+
+    // Lookups that belong to the base are forwarded to it
+    auto typedef_ref = btf->getTypeRef(split_handle, 4);
+    REQUIRE(typedef_ref);
+    CHECK(typedef_ref.name() == "point_t");
+
+    auto struct_ref = btf->getTypeRef(split_handle, 2);
+    REQUIRE(struct_ref);
+    CHECK(struct_ref.name() == "point");
+
+    // Both split files use the type IDs that follow the base
+    auto opt_other_typedef = btf->getType(other_split_handle, 3);
+    REQUIRE(opt_other_typedef.has_value());
+    CHECK(std::get<TypedefBTFType>(opt_other_typedef.value()).name ==
+          "other");
+
+    CHECK(!btf->getType(other_split_handle, 4).has_value());
+
+    CHECK(btf->detach(split_handle));
+    CHECK(!btf->detach(split_handle));
+    CHECK(!btf->getType(split_handle, 4).has_value());
+    CHECK(!btf->getTypeRef(split_handle, 4));
+    CHECK(btf->getAll(split_handle).empty());
+
+    CHECK(btf->getType(other_split_handle, 3).has_value());
+
+    auto missing_split_res = btf->attachSplit(
+        std::filesystem::temp_directory_path() / "btfparse-tests-missing");
+
+    REQUIRE(missing_split_res.failed());
+    CHECK(missing_split_res.error().get().code ==
+          BTFErrorInformation::Code::FileNotFound);
+  }
+
+  // Objects created with split files attach new ones to the first file
+  // only, reusing the type IDs of the existing split files
+  for (auto lazy : {false, true}) {
+    BTFOptions options;
+    options.lazy = lazy;
+
+    auto btf_res = IBTF::createFromPathList({base_path, split_path}, options);
+    REQUIRE(!btf_res.failed());
+
+    auto btf = btf_res.takeValue();
+    CHECK(btf->count() == 4);
+
+    auto other_split_handle_res = btf->attachSplit(other_split_path);
+    REQUIRE(!other_split_handle_res.failed());
+
+    auto other_split_handle = other_split_handle_res.takeValue();
+    CHECK(btf->getAll(other_split_handle).size() == 1);
+
+    auto opt_other_typedef = btf->getType(other_split_handle, 3);
+    REQUIRE(opt_other_typedef.has_value());
+
+    const auto &other_typedef =
+        std::get<TypedefBTFType>(opt_other_typedef.value());
+
+    CHECK(other_typedef.name == "other");
+    CHECK(other_typedef.type == 1);
+
+    // The types of the split file passed at creation are not visible
+    CHECK(!btf->getType(other_split_handle, 4).has_value());
+    CHECK(!btf->getTypeRef(other_split_handle, 4));
+    CHECK(btf->getType(other_split_handle, 1).has_value());
+
+    CHECK(std::get<TypedefBTFType>(btf->getType(4).value()).name ==
+          "point_t");
+  }
+
+  // Objects created from a stream do not retain the base data
+  SequentialStream stream(base.build());
+
+  auto btf_res = IBTF::createFromStream(stream);
+  REQUIRE(!btf_res.failed());
+
+  auto split_handle_res = btf_res.takeValue()->attachSplit(split_path);
+  REQUIRE(split_handle_res.failed());
+  CHECK(split_handle_res.error().get().code ==
+        BTFErrorInformation::Code::BaseBTFNotAvailable);
+
+  std::filesystem::remove(base_path);
+  std::filesystem::remove(split_path);
+  std::filesystem::remove(other_split_path);
+}
+
+} // namespace btfparse
@@ -24,6 +24,10 @@ struct FileReaderErrorInformation final {
     MemoryAllocationFailure,
     FileNotFound,
     IOError,
+    InvalidELFImage,
+    SectionNotFound,
+    UnsupportedCompressionFormat,
+    DecompressionError,
   };
 
   struct ReadOperation final {
@@ -59,6 +63,22 @@ struct FileReaderErrorInformationPrinter final {
     case FileReaderErrorInformation::Code::IOError:
       buffer << "IO error";
       break;
+
+    case FileReaderErrorInformation::Code::InvalidELFImage:
+      buffer << "Invalid ELF image";
+      break;
+
+    case FileReaderErrorInformation::Code::SectionNotFound:
+      buffer << "Section not found";
+      break;
+
+    case FileReaderErrorInformation::Code::UnsupportedCompressionFormat:
+      buffer << "Unsupported compression format";
+      break;
+
+    case FileReaderErrorInformation::Code::DecompressionError:
+      buffer << "Decompression error";
+      break;
     }
 
     buffer << "'";
@@ -80,11 +100,21 @@ class IFileReader {
 public:
   using Ptr = std::unique_ptr<IFileReader>;
 
+  // ELF images (such as vmlinux and kernel modules) are detected
+  // automatically, and only their .BTF section is exposed. Files compressed
+  // with gzip, xz or zstd are decompressed until the BTF data is found
   static Result<Ptr, FileReaderError>
   open(const std::filesystem::path &path) noexcept;
   static Result<Ptr, FileReaderError>
   createFromStream(IStream::Ptr stream) noexcept;
 
+  // Reads directly from the given memory. When `owner` is not set, the
+  // buffer is borrowed and must outlive the returned reader. ELF images are
+  // handled in the same way as in `open`
+  static Result<Ptr, FileReaderError>
+  createFromBuffer(ByteSpan buffer,
+                   std::shared_ptr<const void> owner = nullptr) noexcept;
+
   IFileReader() = default;
   virtual ~IFileReader() = default;
 
@@ -99,6 +129,17 @@ public:
   virtual std::uint32_t u32() = 0;
   virtual std::uint64_t u64() = 0;
 
+  // Reads `size` bytes from the given offset, without moving the current
+  // position; may be called concurrently. The default implementation
+  // always throws a FileReaderError
+  virtual void readAt(std::uint64_t offset, std::uint8_t *buffer,
+                      std::size_t size) const;
+
+  // Returns std::nullopt by default, or when the data is not memory-resident
+  virtual std::optional<ByteSpan> view(std::uint64_t, std::size_t) const {
+    return std::nullopt;
+  }
+
   IFileReader(const IFileReader &) = delete;
   IFileReader &operator=(const IFileReader &) = delete;
 };
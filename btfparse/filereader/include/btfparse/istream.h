@@ -8,8 +8,11 @@
 
 #pragma once
 
+#include <btfparse/bytespan.h>
+
 #include <cstdint>
 #include <memory>
+#include <optional>
 
 namespace btfparse {
 
@@ -17,6 +20,10 @@ class IStream {
 public:
   using Ptr = std::unique_ptr<IStream>;
 
+  // Wraps an open file descriptor that only supports sequential reads,
+  // such as a pipe, a socket or stdin. The descriptor is not closed
+  static Ptr createFromFileDescriptor(int fd);
+
   IStream() = default;
   virtual ~IStream() = default;
 
@@ -25,6 +32,17 @@ public:
 
   virtual bool read(std::uint8_t *buffer, std::size_t size) = 0;
 
+  // Positional read that does not use or update the stream offset. It is
+  // safe to call from multiple threads at the same time. Streams that can
+  // only be read sequentially keep the default implementation, which fails
+  virtual bool readAt(std::uint64_t, std::uint8_t *, std::size_t) const {
+    return false;
+  }
+
+  // Streams that are entirely memory-resident can expose their contents,
+  // allowing readers to access the data in place
+  virtual std::optional<ByteSpan> view() const { return std::nullopt; }
+
   IStream(const IStream &) = delete;
   IStream &operator=(const IStream &) = delete;
 };
@@ -0,0 +1,650 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "compressedfilestream.h"
+#include "elfimage.h"
+
+#include <btfparse/ifilereader.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+namespace btfparse {
+
+namespace {
+
+const std::size_t kInputChunkSize{64U * 1024U};
+const std::size_t kOutputChunkSize{64U * 1024U};
+const std::size_t kMaxBTFSize{1024U * 1024U * 1024U};
+const std::size_t kMaxSectionTableSize{16U * 1024U * 1024U};
+
+// Upper bound on the number of places where the .BTF section name is
+// remembered while an ELF image is decompressed
+const std::size_t kMaxSectionNameCount{64U * 1024U};
+
+const std::string_view kBTFSectionName{".BTF"};
+
+const std::uint16_t kBTFMagic{0xEB9FU};
+
+FileReaderError decompressionError() {
+  return FileReaderError(FileReaderErrorInformation{
+      FileReaderErrorInformation::Code::DecompressionError});
+}
+
+FileReaderError invalidELFImage() {
+  return FileReaderError(FileReaderErrorInformation{
+      FileReaderErrorInformation::Code::InvalidELFImage});
+}
+
+std::uint32_t readU32(const std::uint8_t *buffer, bool little_endian) {
+  if (little_endian) {
+    return static_cast<std::uint32_t>(buffer[0]) |
+           (static_cast<std::uint32_t>(buffer[1]) << 8) |
+           (static_cast<std::uint32_t>(buffer[2]) << 16) |
+           (static_cast<std::uint32_t>(buffer[3]) << 24);
+  }
+
+  return static_cast<std::uint32_t>(buffer[3]) |
+         (static_cast<std::uint32_t>(buffer[2]) << 8) |
+         (static_cast<std::uint32_t>(buffer[1]) << 16) |
+         (static_cast<std::uint32_t>(buffer[0]) << 24);
+}
+
+// Returns true if the bytes start with the BTF magic, in either byte order,
+// and sets `little_endian` accordingly. Reads two bytes
+bool hasBTFMagic(const std::uint8_t *header, bool &little_endian) {
+  if (header[0] == (kBTFMagic & 0xFF) && header[1] == (kBTFMagic >> 8)) {
+    little_endian = true;
+    return true;
+  }
+
+  if (header[0] == (kBTFMagic >> 8) && header[1] == (kBTFMagic & 0xFF)) {
+    little_endian = false;
+    return true;
+  }
+
+  return false;
+}
+
+// Returns the size of the data that follows a BTF header found inside an
+// ELF image. Unlike CompressedFileStream::getBTFSize, any layout of the
+// type and string sections is accepted, since the section headers have the
+// final word. Reads kBTFHeaderSize bytes
+std::optional<std::uint64_t> getBTFCandidateSize(const std::uint8_t *header) {
+  bool little_endian{};
+  if (!hasBTFMagic(header, little_endian) || header[2] != 1 ||
+      header[3] != 0) {
+    return std::nullopt;
+  }
+
+  auto hdr_len = readU32(header + 4, little_endian);
+  if (hdr_len < CompressedFileStream::kBTFHeaderSize) {
+    return std::nullopt;
+  }
+
+  auto type_end =
+      static_cast<std::uint64_t>(readU32(header + 8, little_endian)) +
+      readU32(header + 12, little_endian);
+
+  auto str_end =
+      static_cast<std::uint64_t>(readU32(header + 16, little_endian)) +
+      readU32(header + 20, little_endian);
+
+  auto size = hdr_len + std::max(type_end, str_end);
+  if (size > kMaxBTFSize) {
+    return std::nullopt;
+  }
+
+  return size;
+}
+
+// Pulls decompressed data out of a compressed buffer, feeding the
+// decompressor one chunk at a time
+class DecompressedReader final {
+  ByteSpan compressed_data;
+  IDecompressor &decompressor;
+  ByteSpan input;
+
+public:
+  DecompressedReader(ByteSpan compressed_data_, IDecompressor &decompressor_)
+      : compressed_data(compressed_data_), decompressor(decompressor_) {}
+
+  // Returns the number of bytes written; zero means end of stream
+  std::size_t read(std::uint8_t *output, std::size_t output_size) {
+    while (!decompressor.finished()) {
+      if (input.empty() && !compressed_data.empty()) {
+        auto input_size = std::min(kInputChunkSize, compressed_data.size());
+
+        input = compressed_data.subspan(0, input_size);
+        compressed_data = compressed_data.subspan(
+            input_size, compressed_data.size() - input_size);
+      }
+
+      auto output_bytes = decompressor.decompress(input, output, output_size);
+      if (output_bytes != 0) {
+        return output_bytes;
+      }
+
+      if (input.empty() && compressed_data.empty()) {
+        throw decompressionError();
+      }
+    }
+
+    return 0;
+  }
+};
+
+// Reads until `size` bytes have been written or the stream ends, and
+// returns the number of bytes written
+std::size_t readFully(DecompressedReader &reader, std::uint8_t *output,
+                      std::size_t size) {
+  std::size_t output_size{0};
+
+  while (output_size < size) {
+    auto read_size = reader.read(output + output_size, size - output_size);
+    if (read_size == 0) {
+      break;
+    }
+
+    output_size += read_size;
+  }
+
+  return output_size;
+}
+
+// Decompresses an ELF image in a single forward pass. Data is discarded as
+// it goes, except for the ranges that are read explicitly and for the
+// blobs that start with a BTF header, one of which is expected to be .BTF.
+// The offsets at which the .BTF section name appears are remembered too,
+// so that the section can be confirmed by name once the section headers
+// have been read, wherever the section names are stored
+class ELFImageReader final {
+  // Bytes starting with a BTF header. Candidates that overlap are merged,
+  // so the blobs are sorted and only the last one may still grow
+  struct Blob final {
+    std::uint64_t offset{};
+    std::uint64_t size{};
+    std::vector<std::uint8_t> data;
+  };
+
+  DecompressedReader &reader;
+  std::uint64_t position{0};
+  bool scanning{true};
+
+  // Decompressed bytes that have not been checked yet, because a BTF
+  // header starting there may continue in the next chunk. The first byte
+  // is at `scan_offset`
+  std::vector<std::uint8_t> scan_buffer;
+  std::uint64_t scan_offset{0};
+
+  std::vector<Blob> blob_list;
+  std::uint64_t blob_list_size{0};
+
+  std::vector<std::uint64_t> section_name_offset_list;
+
+  std::vector<std::uint8_t> discard_buffer;
+
+public:
+  // The header has already been read from `reader_`
+  ELFImageReader(DecompressedReader &reader_, ByteSpan header)
+      : reader(reader_), position(header.size()),
+        discard_buffer(kOutputChunkSize) {
+    scan(header.data(), header.size());
+  }
+
+  // Throws a FileReaderError if the range has already been discarded, or if
+  // the stream ends before the whole range has been read
+  std::vector<std::uint8_t> read(const ELFImage::Range &range,
+                                 std::size_t max_size) {
+    if (range.size > max_size || range.offset < scan_offset) {
+      throw invalidELFImage();
+    }
+
+    auto size = static_cast<std::size_t>(range.size);
+
+    std::vector<std::uint8_t> buffer;
+    buffer.reserve(size);
+
+    // The start of the range may still be in the scan buffer
+    if (range.offset < position) {
+      auto copy_begin =
+          scan_buffer.begin() +
+          static_cast<std::ptrdiff_t>(range.offset - scan_offset);
+
+      auto copy_size = static_cast<std::ptrdiff_t>(
+          std::min<std::uint64_t>(range.size, position - range.offset));
+
+      buffer.insert(buffer.end(), copy_begin, copy_begin + copy_size);
+
+    } else {
+      skip(range.offset);
+    }
+
+    while (buffer.size() < size) {
+      auto buffer_size = buffer.size();
+      buffer.resize(std::min(size, buffer_size + kOutputChunkSize));
+
+      auto read_size = decompress(buffer.data() + buffer_size,
+                                  buffer.size() - buffer_size);
+      if (read_size == 0) {
+        throw decompressionError();
+      }
+
+      buffer.resize(buffer_size + read_size);
+    }
+
+    return buffer;
+  }
+
+  // Decompresses and discards the data up to the given offset
+  void skip(std::uint64_t offset) {
+    while (position < offset) {
+      auto skip_size = static_cast<std::size_t>(std::min<std::uint64_t>(
+          offset - position, discard_buffer.size()));
+
+      if (decompress(discard_buffer.data(), skip_size) == 0) {
+        throw decompressionError();
+      }
+    }
+  }
+
+  // Returns true if the .BTF section name, followed by its terminator, has
+  // been seen at the given offset
+  bool hasSectionName(std::uint64_t offset) const {
+    if (offset >= scan_offset) {
+      return isSectionName(ByteSpan(scan_buffer.data(), scan_buffer.size()),
+                           offset - scan_offset);
+    }
+
+    return std::binary_search(section_name_offset_list.begin(),
+                              section_name_offset_list.end(), offset);
+  }
+
+  // Returns the data of the .BTF section. A section that comes before the
+  // current position is only available if it starts with a BTF header
+  std::vector<std::uint8_t> readSection(const ELFImage::Range &range,
+                                        std::size_t max_size) {
+    if (range.size > max_size) {
+      throw invalidELFImage();
+    }
+
+    for (auto &blob : blob_list) {
+      if (range.offset < blob.offset ||
+          range.offset - blob.offset > blob.data.size() ||
+          range.size > blob.data.size() - (range.offset - blob.offset)) {
+        continue;
+      }
+
+      if (range.offset == blob.offset && range.size == blob.data.size()) {
+        return std::move(blob.data);
+      }
+
+      auto section_begin =
+          blob.data.begin() +
+          static_cast<std::ptrdiff_t>(range.offset - blob.offset);
+
+      return std::vector<std::uint8_t>(
+          section_begin,
+          section_begin + static_cast<std::ptrdiff_t>(range.size));
+    }
+
+    if (range.offset < scan_offset) {
+      throw FileReaderError(FileReaderErrorInformation{
+          FileReaderErrorInformation::Code::SectionNotFound});
+    }
+
+    // The rest of the image is only read forward, so the candidates are no
+    // longer needed
+    scanning = false;
+    blob_list = {};
+
+    return read(range, max_size);
+  }
+
+private:
+  // Same as DecompressedReader::read, but also scans the data
+  std::size_t decompress(std::uint8_t *output, std::size_t size) {
+    auto read_size = reader.read(output, size);
+
+    position += read_size;
+    scan(output, read_size);
+
+    return read_size;
+  }
+
+  void scan(const std::uint8_t *data, std::size_t size) {
+    if (!scanning) {
+      scan_buffer.clear();
+      scan_offset = position;
+      return;
+    }
+
+    scan_buffer.insert(scan_buffer.end(), data, data + size);
+    ByteSpan buffer(scan_buffer.data(), scan_buffer.size());
+
+    // Stop where a BTF header could continue in the next chunk
+    auto scan_end =
+        buffer.size() -
+        std::min(buffer.size(), CompressedFileStream::kBTFHeaderSize - 1);
+
+    // Either byte order of the magic contains the high byte, which is
+    // rare enough to look for first
+    const std::uint8_t kMagicByte{kBTFMagic >> 8};
+
+    for (auto i : findByte(buffer, scan_end + 1, kMagicByte)) {
+      bool little_endian{};
+      if (i > 0 && hasBTFMagic(buffer.data() + i - 1, little_endian) &&
+          little_endian) {
+        addBlob(scan_offset + i - 1, buffer.data() + i - 1);
+      }
+
+      if (i < scan_end && hasBTFMagic(buffer.data() + i, little_endian) &&
+          !little_endian) {
+        addBlob(scan_offset + i, buffer.data() + i);
+      }
+    }
+
+    fillLastBlob();
+
+    for (auto i : findByte(buffer, scan_end,
+                           static_cast<std::uint8_t>(kBTFSectionName[0]))) {
+      if (section_name_offset_list.size() < kMaxSectionNameCount &&
+          isSectionName(buffer, i)) {
+        section_name_offset_list.push_back(scan_offset + i);
+      }
+    }
+
+    scan_buffer.erase(scan_buffer.begin(),
+                      scan_buffer.begin() +
+                          static_cast<std::ptrdiff_t>(scan_end));
+
+    scan_offset += scan_end;
+  }
+
+  // Returns the positions of the given byte in the first `size` bytes of the
+  // buffer
+  static std::vector<std::size_t> findByte(ByteSpan buffer, std::size_t size,
+                                           std::uint8_t value) {
+    std::vector<std::size_t> position_list;
+
+    size = std::min(size, buffer.size());
+    for (std::size_t i = 0; i < size;) {
+      auto ptr = std::memchr(buffer.data() + i, value, size - i);
+      if (ptr == nullptr) {
+        break;
+      }
+
+      i = static_cast<std::size_t>(static_cast<const std::uint8_t *>(ptr) -
+                                   buffer.data());
+
+      position_list.push_back(i);
+      ++i;
+    }
+
+    return position_list;
+  }
+
+  static bool isSectionName(ByteSpan buffer, std::uint64_t offset) {
+    auto name_size = kBTFSectionName.size();
+    if (!buffer.contains(offset, name_size + 1)) {
+      return false;
+    }
+
+    auto name = buffer.data() + offset;
+    return std::memcmp(name, kBTFSectionName.data(), name_size) == 0 &&
+           name[name_size] == 0;
+  }
+
+  void addBlob(std::uint64_t offset, const std::uint8_t *header) {
+    auto opt_size = getBTFCandidateSize(header);
+    if (!opt_size.has_value()) {
+      return;
+    }
+
+    auto size = opt_size.value();
+    auto end = offset + size;
+
+    if (!blob_list.empty()) {
+      auto &last_blob = blob_list.back();
+      auto last_blob_end = last_blob.offset + last_blob.size;
+
+      if (offset < last_blob_end) {
+        if (end > last_blob_end &&
+            blob_list_size + (end - last_blob_end) <= kMaxBTFSize) {
+          blob_list_size += end - last_blob_end;
+          last_blob.size = end - last_blob.offset;
+        }
+
+        return;
+      }
+
+      fillLastBlob();
+    }
+
+    if (blob_list_size + size > kMaxBTFSize) {
+      return;
+    }
+
+    blob_list_size += size;
+    blob_list.push_back(Blob{offset, size, {}});
+  }
+
+  // Copies the bytes of the scan buffer that belong to the last blob
+  void fillLastBlob() {
+    if (blob_list.empty()) {
+      return;
+    }
+
+    auto &blob = blob_list.back();
+    auto blob_position = blob.offset + blob.data.size();
+    auto blob_end = blob.offset + blob.size;
+
+    auto buffer_end = scan_offset + scan_buffer.size();
+    if (blob_position >= blob_end || blob_position >= buffer_end) {
+      return;
+    }
+
+    auto copy_begin = scan_buffer.begin() +
+                      static_cast<std::ptrdiff_t>(blob_position - scan_offset);
+
+    auto copy_size =
+        static_cast<std::ptrdiff_t>(std::min(blob_end, buffer_end) -
+                                    blob_position);
+
+    blob.data.insert(blob.data.end(), copy_begin, copy_begin + copy_size);
+  }
+};
+
+// Locates the .BTF section of a compressed ELF image and returns a copy of
+// its data, without ever going back in the stream. Only the ELF header, the
+// section headers, the BTF candidates and .BTF are kept in memory
+std::vector<std::uint8_t> readBTFSection(ELFImageReader &reader,
+                                         ByteSpan header) {
+  auto first_section_header_range =
+      ELFImage::getFirstSectionHeaderRange(header);
+
+  auto section_table =
+      reader.read(first_section_header_range, kMaxSectionTableSize);
+
+  auto section_table_range = ELFImage::getSectionTableRange(
+      header, ByteSpan(section_table.data(), section_table.size()));
+
+  if (section_table_range.size > kMaxSectionTableSize) {
+    throw invalidELFImage();
+  }
+
+  // The rest of the table immediately follows its first entry
+  auto remaining_section_table = reader.read(
+      ELFImage::Range{first_section_header_range.offset + section_table.size(),
+                      section_table_range.size - section_table.size()},
+      kMaxSectionTableSize);
+
+  section_table.insert(section_table.end(), remaining_section_table.begin(),
+                       remaining_section_table.end());
+
+  ByteSpan section_table_span(section_table.data(), section_table.size());
+
+  // The section names usually come before the section headers, but may
+  // also follow them
+  auto string_table_range =
+      ELFImage::getStringTableRange(header, section_table_span);
+
+  if (string_table_range.size >
+      std::numeric_limits<std::uint64_t>::max() - string_table_range.offset) {
+    throw invalidELFImage();
+  }
+
+  reader.skip(string_table_range.offset + string_table_range.size);
+
+  auto btf_section_range = ELFImage::getSectionRange(
+      header, section_table_span, string_table_range,
+      [&reader](std::uint64_t offset) -> bool {
+        return reader.hasSectionName(offset);
+      });
+
+  return reader.readSection(btf_section_range, kMaxBTFSize);
+}
+
+} // namespace
+
+IStream::Ptr CompressedFileStream::create(ByteSpan compressed_data,
+                                          IDecompressor::Format format) {
+  try {
+    auto decompressor = IDecompressor::create(format);
+    DecompressedReader reader(compressed_data, *decompressor);
+
+    // Raw BTF files start with the BTF header, and ELF images with the ELF
+    // header, which is the larger of the two
+    std::vector<std::uint8_t> buffer(ELFImage::kHeaderSize);
+    buffer.resize(readFully(reader, buffer.data(), buffer.size()));
+
+    ByteSpan header(buffer.data(), buffer.size());
+
+    if (ELFImage::isELFImage(header)) {
+      ELFImageReader image_reader(reader, header);
+      return Ptr(
+          new CompressedFileStream(readBTFSection(image_reader, header)));
+    }
+
+    std::optional<std::size_t> opt_btf_size;
+    if (buffer.size() >= kBTFHeaderSize) {
+      opt_btf_size = getBTFSize(buffer.data());
+    }
+
+    if (!opt_btf_size.has_value()) {
+      throw FileReaderError(FileReaderErrorInformation{
+          FileReaderErrorInformation::Code::SectionNotFound});
+    }
+
+    auto btf_size = opt_btf_size.value();
+
+    // The header may have been read along with some of the data that
+    // follows the BTF blob
+    if (buffer.size() >= btf_size) {
+      buffer.resize(btf_size);
+
+    } else {
+      auto remaining_size = btf_size - buffer.size();
+
+      auto buffer_size = buffer.size();
+      buffer.resize(btf_size);
+
+      if (readFully(reader, buffer.data() + buffer_size, remaining_size) !=
+          remaining_size) {
+        throw decompressionError();
+      }
+    }
+
+    return Ptr(new CompressedFileStream(std::move(buffer)));
+
+  } catch (const std::bad_alloc &) {
+    throw FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+CompressedFileStream::~CompressedFileStream() {}
+
+bool CompressedFileStream::seek(std::uint64_t offset) {
+  if (offset >= section_buffer.size()) {
+    return false;
+  }
+
+  section_pos = static_cast<std::size_t>(offset);
+
+  return true;
+}
+
+std::uint64_t CompressedFileStream::offset() const {
+  return static_cast<std::uint64_t>(section_pos);
+}
+
+bool CompressedFileStream::read(std::uint8_t *buffer, std::size_t size) {
+  if (!readAt(section_pos, buffer, size)) {
+    return false;
+  }
+
+  section_pos += size;
+
+  return true;
+}
+
+bool CompressedFileStream::readAt(std::uint64_t offset, std::uint8_t *buffer,
+                                  std::size_t size) const {
+  ByteSpan section(section_buffer.data(), section_buffer.size());
+  if (!section.contains(offset, size)) {
+    return false;
+  }
+
+  std::memcpy(buffer, section_buffer.data() + offset, size);
+
+  return true;
+}
+
+std::optional<ByteSpan> CompressedFileStream::view() const {
+  return ByteSpan(section_buffer.data(), section_buffer.size());
+}
+
+std::optional<std::size_t>
+CompressedFileStream::getBTFSize(const std::uint8_t *header) {
+  bool little_endian{};
+  if (!hasBTFMagic(header, little_endian)) {
+    return std::nullopt;
+  }
+
+  // version (1), flags (0) and hdr_len (24). The rest of the header is
+  // checked against the layout that is always emitted by pahole and
+  // libbpf: the type section comes first, immediately followed by the
+  // string section
+  auto hdr_len = readU32(header + 4, little_endian);
+  auto type_off = readU32(header + 8, little_endian);
+  auto type_len = readU32(header + 12, little_endian);
+  auto str_off = readU32(header + 16, little_endian);
+  auto str_len = readU32(header + 20, little_endian);
+
+  if (header[2] != 1 || header[3] != 0 || hdr_len != kBTFHeaderSize ||
+      type_off != 0 || (type_len % 4) != 0 || str_off != type_len ||
+      str_len == 0) {
+    return std::nullopt;
+  }
+
+  auto btf_size = static_cast<std::size_t>(hdr_len) + str_off + str_len;
+  if (btf_size > kMaxBTFSize) {
+    return std::nullopt;
+  }
+
+  return btf_size;
+}
+
+CompressedFileStream::CompressedFileStream(std::vector<std::uint8_t> buffer)
+    : section_buffer(std::move(buffer)) {}
+
+} // namespace btfparse
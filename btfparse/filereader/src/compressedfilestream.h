@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include "decompressor.h"
+
+#include <btfparse/istream.h>
+
+#include <optional>
+#include <vector>
+
+namespace btfparse {
+
+// Exposes the BTF data found inside a compressed file: either the .BTF
+// section of an ELF image (such as a .ko.xz kernel module), which is
+// located through the section headers, or a raw BTF file. The file is
+// decompressed in a single forward pass, and only the BTF data is
+// retained: ELF images are decompressed up to their section headers and
+// section names, and raw BTF files up to the end of their data
+class CompressedFileStream final : public IStream {
+private:
+  std::vector<std::uint8_t> section_buffer;
+  std::size_t section_pos{0};
+
+public:
+  CompressedFileStream() = delete;
+
+  // The compressed data is only used while the stream is created
+  static Ptr create(ByteSpan compressed_data, IDecompressor::Format format);
+
+  virtual ~CompressedFileStream() override;
+
+  virtual bool seek(std::uint64_t offset) override;
+  virtual std::uint64_t offset() const override;
+  virtual bool read(std::uint8_t *buffer, std::size_t size) override;
+  virtual bool readAt(std::uint64_t offset, std::uint8_t *buffer,
+                      std::size_t size) const override;
+  virtual std::optional<ByteSpan> view() const override;
+
+  // Returns the size of the BTF data starting with the given header, or
+  // std::nullopt if the bytes do not look like a valid BTF header. Reads
+  // kBTFHeaderSize bytes
+  static std::optional<std::size_t> getBTFSize(const std::uint8_t *header);
+
+  static constexpr std::size_t kBTFHeaderSize{24U};
+
+private:
+  CompressedFileStream(std::vector<std::uint8_t> buffer);
+};
+
+} // namespace btfparse
@@ -0,0 +1,212 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "decompressor.h"
+
+#include <btfparse/ifilereader.h>
+
+#include <cstring>
+
+#ifdef BTFPARSE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef BTFPARSE_HAVE_XZ
+#include <lzma.h>
+#endif
+
+#ifdef BTFPARSE_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace btfparse {
+
+namespace {
+
+const std::uint8_t kGzipMagic[]{0x1F, 0x8B};
+const std::uint8_t kXzMagic[]{0xFD, '7', 'z', 'X', 'Z', 0x00};
+const std::uint8_t kZstdMagic[]{0x28, 0xB5, 0x2F, 0xFD};
+
+template <std::size_t size>
+bool hasMagic(ByteSpan header, const std::uint8_t (&magic)[size]) {
+  return header.size() >= size && std::memcmp(header.data(), magic, size) == 0;
+}
+
+FileReaderError decompressionError() {
+  return FileReaderError(FileReaderErrorInformation{
+      FileReaderErrorInformation::Code::DecompressionError});
+}
+
+#ifdef BTFPARSE_HAVE_ZLIB
+class GzipDecompressor final : public IDecompressor {
+  z_stream stream{};
+  bool stream_end{false};
+
+public:
+  GzipDecompressor() {
+    // 15 bits of window, +16 to only accept the gzip format
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+      throw std::bad_alloc();
+    }
+  }
+
+  virtual ~GzipDecompressor() override { inflateEnd(&stream); }
+
+  virtual std::size_t decompress(ByteSpan &input, std::uint8_t *output,
+                                 std::size_t output_size) override {
+    if (stream_end) {
+      return 0;
+    }
+
+    stream.next_in = const_cast<Bytef *>(input.data());
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = output;
+    stream.avail_out = static_cast<uInt>(output_size);
+
+    auto error = inflate(&stream, Z_NO_FLUSH);
+    if (error == Z_STREAM_END) {
+      stream_end = true;
+
+    } else if (error != Z_OK && error != Z_BUF_ERROR) {
+      throw decompressionError();
+    }
+
+    input = input.subspan(input.size() - stream.avail_in, stream.avail_in);
+    return output_size - stream.avail_out;
+  }
+
+  virtual bool finished() const override { return stream_end; }
+};
+#endif
+
+#ifdef BTFPARSE_HAVE_XZ
+class XzDecompressor final : public IDecompressor {
+  lzma_stream stream = LZMA_STREAM_INIT;
+  bool stream_end{false};
+
+public:
+  XzDecompressor() {
+    if (lzma_stream_decoder(&stream, UINT64_MAX, 0) != LZMA_OK) {
+      throw std::bad_alloc();
+    }
+  }
+
+  virtual ~XzDecompressor() override { lzma_end(&stream); }
+
+  virtual std::size_t decompress(ByteSpan &input, std::uint8_t *output,
+                                 std::size_t output_size) override {
+    if (stream_end) {
+      return 0;
+    }
+
+    stream.next_in = input.data();
+    stream.avail_in = input.size();
+    stream.next_out = output;
+    stream.avail_out = output_size;
+
+    auto error = lzma_code(&stream, LZMA_RUN);
+    if (error == LZMA_STREAM_END) {
+      stream_end = true;
+
+    } else if (error != LZMA_OK && error != LZMA_BUF_ERROR) {
+      throw decompressionError();
+    }
+
+    input = input.subspan(input.size() - stream.avail_in, stream.avail_in);
+    return output_size - stream.avail_out;
+  }
+
+  virtual bool finished() const override { return stream_end; }
+};
+#endif
+
+#ifdef BTFPARSE_HAVE_ZSTD
+class ZstdDecompressor final : public IDecompressor {
+  ZSTD_DStream *stream{nullptr};
+  bool stream_end{false};
+
+public:
+  ZstdDecompressor() {
+    stream = ZSTD_createDStream();
+    if (stream == nullptr) {
+      throw std::bad_alloc();
+    }
+  }
+
+  virtual ~ZstdDecompressor() override { ZSTD_freeDStream(stream); }
+
+  virtual std::size_t decompress(ByteSpan &input, std::uint8_t *output,
+                                 std::size_t output_size) override {
+    if (stream_end) {
+      return 0;
+    }
+
+    ZSTD_inBuffer in_buffer{input.data(), input.size(), 0};
+    ZSTD_outBuffer out_buffer{output, output_size, 0};
+
+    auto res = ZSTD_decompressStream(stream, &out_buffer, &in_buffer);
+    if (ZSTD_isError(res)) {
+      throw decompressionError();
+    }
+
+    // A return value of zero means that a frame has been fully decoded
+    // and flushed
+    if (res == 0) {
+      stream_end = true;
+    }
+
+    input = input.subspan(in_buffer.pos, input.size() - in_buffer.pos);
+    return out_buffer.pos;
+  }
+
+  virtual bool finished() const override { return stream_end; }
+};
+#endif
+
+} // namespace
+
+IDecompressor::Format IDecompressor::detectFormat(ByteSpan header) noexcept {
+  if (hasMagic(header, kGzipMagic)) {
+    return Format::Gzip;
+
+  } else if (hasMagic(header, kXzMagic)) {
+    return Format::Xz;
+
+  } else if (hasMagic(header, kZstdMagic)) {
+    return Format::Zstd;
+  }
+
+  return Format::None;
+}
+
+IDecompressor::Ptr IDecompressor::create(Format format) {
+  switch (format) {
+#ifdef BTFPARSE_HAVE_ZLIB
+  case Format::Gzip:
+    return std::make_unique<GzipDecompressor>();
+#endif
+
+#ifdef BTFPARSE_HAVE_XZ
+  case Format::Xz:
+    return std::make_unique<XzDecompressor>();
+#endif
+
+#ifdef BTFPARSE_HAVE_ZSTD
+  case Format::Zstd:
+    return std::make_unique<ZstdDecompressor>();
+#endif
+
+  default:
+    break;
+  }
+
+  throw FileReaderError(FileReaderErrorInformation{
+      FileReaderErrorInformation::Code::UnsupportedCompressionFormat});
+}
+
+} // namespace btfparse
@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/bytespan.h>
+
+#include <memory>
+
+namespace btfparse {
+
+class IDecompressor {
+public:
+  using Ptr = std::unique_ptr<IDecompressor>;
+
+  enum class Format {
+    None,
+    Gzip,
+    Xz,
+    Zstd,
+  };
+
+  // Number of bytes needed by detectFormat
+  static constexpr std::size_t kMagicSize{6U};
+
+  static Format detectFormat(ByteSpan header) noexcept;
+
+  // Throws a FileReaderError if support for the given format has not
+  // been compiled in
+  static Ptr create(Format format);
+
+  IDecompressor() = default;
+  virtual ~IDecompressor() = default;
+
+  // Consumes bytes from `input` (advancing it) and returns how many bytes
+  // have been written to `output`. Throws a FileReaderError on corrupted
+  // input
+  virtual std::size_t decompress(ByteSpan &input, std::uint8_t *output,
+                                 std::size_t output_size) = 0;
+
+  // True once the end of the compressed stream has been reached
+  virtual bool finished() const = 0;
+
+  IDecompressor(const IDecompressor &) = delete;
+  IDecompressor &operator=(const IDecompressor &) = delete;
+};
+
+} // namespace btfparse
@@ -0,0 +1,278 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "elfimage.h"
+
+#include <btfparse/ifilereader.h>
+
+#include <cstring>
+#include <limits>
+
+namespace btfparse {
+
+namespace {
+
+const std::uint8_t kELFMagic[]{0x7F, 'E', 'L', 'F'};
+
+const std::size_t kELFClassOffset{4U};
+const std::size_t kELFDataOffset{5U};
+const std::uint8_t kELFClass32{1U};
+const std::uint8_t kELFClass64{2U};
+const std::uint8_t kELFDataLittleEndian{1U};
+const std::uint8_t kELFDataBigEndian{2U};
+
+const std::uint32_t kSectionTypeNoBits{8U};
+const std::uint64_t kSectionFlagCompressed{0x800U};
+const std::uint16_t kSectionIndexExtended{0xFFFFU};
+
+FileReaderError invalidELFImage() {
+  return FileReaderError(FileReaderErrorInformation{
+      FileReaderErrorInformation::Code::InvalidELFImage});
+}
+
+} // namespace
+
+bool ELFImage::isELFImage(ByteSpan image) noexcept {
+  return image.size() >= sizeof(kELFMagic) &&
+         std::memcmp(image.data(), kELFMagic, sizeof(kELFMagic)) == 0;
+}
+
+ByteSpan ELFImage::getSection(ByteSpan image, std::string_view name) {
+  auto first_section_header =
+      getRangeData(image, getFirstSectionHeaderRange(image));
+
+  auto section_table = getRangeData(
+      image, getSectionTableRange(image, first_section_header));
+
+  auto string_table =
+      getRangeData(image, getStringTableRange(image, section_table));
+
+  return getRangeData(
+      image, getSectionRange(image, section_table, string_table, name));
+}
+
+ELFImage::Range ELFImage::getFirstSectionHeaderRange(ByteSpan header) {
+  auto section_table = readSectionTable(createContext(header));
+  return Range{section_table.offset, section_table.entry_size};
+}
+
+ELFImage::Range ELFImage::getSectionTableRange(ByteSpan header,
+                                               ByteSpan first_section_header) {
+  auto context = createContext(header);
+  auto section_table = readSectionTable(context);
+
+  // Images with too many sections store the real count inside the first
+  // section header
+  auto section_count = section_table.count;
+  if (section_count == 0) {
+    section_count =
+        readSectionHeader(context, first_section_header, 0).size;
+  }
+
+  if (section_count == 0 ||
+      section_count > (std::numeric_limits<std::uint64_t>::max() /
+                       section_table.entry_size)) {
+    throw invalidELFImage();
+  }
+
+  return Range{section_table.offset, section_count * section_table.entry_size};
+}
+
+ELFImage::Range ELFImage::getStringTableRange(ByteSpan header,
+                                              ByteSpan section_table) {
+  auto context = createContext(header);
+  auto string_table_index = readSectionTable(context).string_table_index;
+
+  if (string_table_index == kSectionIndexExtended) {
+    string_table_index = readSectionHeader(context, section_table, 0).link;
+  }
+
+  return getDataRange(
+      readSectionHeader(context, section_table, string_table_index));
+}
+
+ELFImage::Range ELFImage::getSectionRange(ByteSpan header,
+                                          ByteSpan section_table,
+                                          ByteSpan string_table,
+                                          std::string_view name) {
+  auto has_name = [&string_table, name](std::uint64_t offset) -> bool {
+    auto name_ptr =
+        reinterpret_cast<const char *>(string_table.data()) + offset;
+
+    auto max_name_length = string_table.size() - offset;
+    std::string_view section_name(name_ptr,
+                                  strnlen(name_ptr, max_name_length));
+
+    return section_name == name;
+  };
+
+  return getSectionRange(header, section_table,
+                         Range{0, string_table.size()}, has_name);
+}
+
+ELFImage::Range ELFImage::getSectionRange(ByteSpan header,
+                                          ByteSpan section_table,
+                                          const Range &string_table_range,
+                                          const SectionNameMatcher &has_name) {
+  auto context = createContext(header);
+  auto section_count =
+      section_table.size() / readSectionTable(context).entry_size;
+
+  for (std::uint64_t i = 1; i < section_count; ++i) {
+    auto section_header = readSectionHeader(context, section_table, i);
+
+    if (section_header.name >= string_table_range.size) {
+      throw invalidELFImage();
+    }
+
+    if (has_name(string_table_range.offset + section_header.name)) {
+      return getDataRange(section_header);
+    }
+  }
+
+  throw FileReaderError(FileReaderErrorInformation{
+      FileReaderErrorInformation::Code::SectionNotFound});
+}
+
+ELFImage::Context ELFImage::createContext(ByteSpan image) {
+  if (!isELFImage(image) || image.size() <= kELFDataOffset) {
+    throw invalidELFImage();
+  }
+
+  Context context;
+  context.image = image;
+
+  auto elf_class = image[kELFClassOffset];
+  if (elf_class != kELFClass32 && elf_class != kELFClass64) {
+    throw invalidELFImage();
+  }
+
+  context.is_64bit = elf_class == kELFClass64;
+
+  auto elf_data = image[kELFDataOffset];
+  if (elf_data != kELFDataLittleEndian && elf_data != kELFDataBigEndian) {
+    throw invalidELFImage();
+  }
+
+  context.little_endian = elf_data == kELFDataLittleEndian;
+  return context;
+}
+
+ELFImage::SectionTable ELFImage::readSectionTable(const Context &context) {
+  SectionTable section_table;
+
+  if (context.is_64bit) {
+    section_table.offset = u64(context, 0x28);
+    section_table.entry_size = u16(context, 0x3A);
+    section_table.count = u16(context, 0x3C);
+    section_table.string_table_index = u16(context, 0x3E);
+
+  } else {
+    section_table.offset = u32(context, 0x20);
+    section_table.entry_size = u16(context, 0x2E);
+    section_table.count = u16(context, 0x30);
+    section_table.string_table_index = u16(context, 0x32);
+  }
+
+  auto minimum_entry_size = context.is_64bit ? 0x40U : 0x28U;
+  if (section_table.offset == 0 ||
+      section_table.entry_size < minimum_entry_size) {
+    throw invalidELFImage();
+  }
+
+  return section_table;
+}
+
+std::uint16_t ELFImage::u16(const Context &context, std::uint64_t offset) {
+  if (!context.image.contains(offset, 2)) {
+    throw invalidELFImage();
+  }
+
+  auto ptr = context.image.data() + offset;
+  if (context.little_endian) {
+    return static_cast<std::uint16_t>(ptr[0] | (ptr[1] << 8));
+  }
+
+  return static_cast<std::uint16_t>(ptr[1] | (ptr[0] << 8));
+}
+
+std::uint32_t ELFImage::u32(const Context &context, std::uint64_t offset) {
+  auto low = u16(context, offset + (context.little_endian ? 0 : 2));
+  auto high = u16(context, offset + (context.little_endian ? 2 : 0));
+
+  return static_cast<std::uint32_t>(low) |
+         (static_cast<std::uint32_t>(high) << 16);
+}
+
+std::uint64_t ELFImage::u64(const Context &context, std::uint64_t offset) {
+  auto low = u32(context, offset + (context.little_endian ? 0 : 4));
+  auto high = u32(context, offset + (context.little_endian ? 4 : 0));
+
+  return static_cast<std::uint64_t>(low) |
+         (static_cast<std::uint64_t>(high) << 32);
+}
+
+std::uint64_t ELFImage::word(const Context &context, std::uint64_t offset) {
+  return context.is_64bit ? u64(context, offset) : u32(context, offset);
+}
+
+ELFImage::SectionHeader ELFImage::readSectionHeader(const Context &context,
+                                                    std::uint64_t offset) {
+  SectionHeader section_header;
+  section_header.name = u32(context, offset);
+  section_header.type = u32(context, offset + 4);
+  section_header.flags = word(context, offset + 8);
+
+  if (context.is_64bit) {
+    section_header.offset = u64(context, offset + 0x18);
+    section_header.size = u64(context, offset + 0x20);
+    section_header.link = u32(context, offset + 0x28);
+
+  } else {
+    section_header.offset = u32(context, offset + 0x10);
+    section_header.size = u32(context, offset + 0x14);
+    section_header.link = u32(context, offset + 0x18);
+  }
+
+  return section_header;
+}
+
+ELFImage::SectionHeader ELFImage::readSectionHeader(const Context &context,
+                                                    ByteSpan section_table,
+                                                    std::uint64_t index) {
+  auto entry_size = readSectionTable(context).entry_size;
+  if (index >= section_table.size() / entry_size) {
+    throw invalidELFImage();
+  }
+
+  Context section_table_context = context;
+  section_table_context.image = section_table;
+
+  return readSectionHeader(section_table_context, index * entry_size);
+}
+
+ELFImage::Range ELFImage::getDataRange(const SectionHeader &section_header) {
+  if (section_header.type == kSectionTypeNoBits ||
+      (section_header.flags & kSectionFlagCompressed) != 0) {
+    throw invalidELFImage();
+  }
+
+  return Range{section_header.offset, section_header.size};
+}
+
+ByteSpan ELFImage::getRangeData(ByteSpan image, const Range &range) {
+  if (range.size > image.size() ||
+      !image.contains(range.offset, static_cast<std::size_t>(range.size))) {
+    throw invalidELFImage();
+  }
+
+  return image.subspan(static_cast<std::size_t>(range.offset),
+                       static_cast<std::size_t>(range.size));
+}
+
+} // namespace btfparse
@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/bytespan.h>
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace btfparse {
+
+// Minimal ELF section header parser, used to locate sections (such as .BTF)
+// inside memory-resident vmlinux and kernel module images. Supports both
+// 32-bit and 64-bit images, in either byte order
+class ELFImage final {
+public:
+  static bool isELFImage(ByteSpan image) noexcept;
+
+  // Returns a view of the given section's data. Throws a FileReaderError
+  // if the image is malformed or the section is missing
+  static ByteSpan getSection(ByteSpan image, std::string_view name);
+
+  // Size of the ELF header, which is enough to start a step by step lookup
+  static constexpr std::size_t kHeaderSize{0x40U};
+
+  // A range of bytes inside the image
+  struct Range final {
+    std::uint64_t offset{};
+    std::uint64_t size{};
+  };
+
+  // The following functions locate a section step by step, for images that
+  // are not entirely in memory (such as compressed kernel modules). Each
+  // step only needs the ELF header and the ranges returned by the previous
+  // ones. They throw a FileReaderError if the image is malformed
+
+  // Returns the range of the first section header, which holds the section
+  // count of images with too many sections
+  static Range getFirstSectionHeaderRange(ByteSpan header);
+
+  static Range getSectionTableRange(ByteSpan header,
+                                    ByteSpan first_section_header);
+
+  // Returns the range of the section names
+  static Range getStringTableRange(ByteSpan header, ByteSpan section_table);
+
+  static Range getSectionRange(ByteSpan header, ByteSpan section_table,
+                               ByteSpan string_table, std::string_view name);
+
+  // Called with the image offset of each section name, and returns true if
+  // the wanted name is stored there
+  using SectionNameMatcher = std::function<bool(std::uint64_t offset)>;
+
+  // Same as above, for images whose section names are no longer in memory
+  static Range getSectionRange(ByteSpan header, ByteSpan section_table,
+                               const Range &string_table_range,
+                               const SectionNameMatcher &has_name);
+
+  ELFImage() = delete;
+
+private:
+  struct SectionHeader final {
+    std::uint32_t name{};
+    std::uint32_t type{};
+    std::uint64_t flags{};
+    std::uint64_t offset{};
+    std::uint64_t size{};
+    std::uint32_t link{};
+  };
+
+  struct Context final {
+    ByteSpan image;
+    bool is_64bit{true};
+    bool little_endian{true};
+  };
+
+  // e_shoff, e_shentsize, e_shnum and e_shstrndx
+  struct SectionTable final {
+    std::uint64_t offset{};
+    std::uint16_t entry_size{};
+    std::uint64_t count{};
+    std::uint32_t string_table_index{};
+  };
+
+  static Context createContext(ByteSpan image);
+  static SectionTable readSectionTable(const Context &context);
+
+  static std::uint16_t u16(const Context &context, std::uint64_t offset);
+  static std::uint32_t u32(const Context &context, std::uint64_t offset);
+  static std::uint64_t u64(const Context &context, std::uint64_t offset);
+  static std::uint64_t word(const Context &context, std::uint64_t offset);
+
+  static SectionHeader readSectionHeader(const Context &context,
+                                         std::uint64_t offset);
+
+  static SectionHeader readSectionHeader(const Context &context,
+                                         ByteSpan section_table,
+                                         std::uint64_t index);
+
+  static Range getDataRange(const SectionHeader &section_header);
+  static ByteSpan getRangeData(ByteSpan image, const Range &range);
+};
+
+} // namespace btfparse
@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "filedescriptorstream.h"
+
+#include <cerrno>
+
+#include <unistd.h>
+
+namespace btfparse {
+
+FileDescriptorStream::FileDescriptorStream(int fd_) : fd(fd_) {}
+
+FileDescriptorStream::~FileDescriptorStream() {}
+
+IStream::Ptr FileDescriptorStream::create(int fd) {
+  return Ptr(new FileDescriptorStream(fd));
+}
+
+bool FileDescriptorStream::seek(std::uint64_t offset) {
+  return offset == stream_pos;
+}
+
+std::uint64_t FileDescriptorStream::offset() const { return stream_pos; }
+
+bool FileDescriptorStream::read(std::uint8_t *buffer, std::size_t size) {
+  std::size_t pos{0};
+
+  while (pos < size) {
+    auto read_res = ::read(fd, buffer + pos, size - pos);
+    if (read_res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return false;
+    }
+
+    if (read_res == 0) {
+      return false;
+    }
+
+    pos += static_cast<std::size_t>(read_res);
+    stream_pos += static_cast<std::uint64_t>(read_res);
+  }
+
+  return true;
+}
+
+} // namespace btfparse
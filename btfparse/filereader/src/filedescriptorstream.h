@@ -10,28 +10,27 @@
 
 #include <btfparse/istream.h>
 
-#include <filesystem>
-#include <vector>
-
 namespace btfparse {
 
-class MemoryFileAdapter final : public IStream {
+// Sequential-only stream over a file descriptor that may not support
+// seeking, such as a pipe or a socket. Seeks only succeed when they do not
+// move the current offset, and positional reads are not supported
+class FileDescriptorStream final : public IStream {
 private:
-  std::unique_ptr<char[]> file_buffer;
-  std::size_t file_pos;
-  const std::size_t file_buffer_size;
+  int fd{-1};
+  std::uint64_t stream_pos{0};
 
 public:
-  MemoryFileAdapter() = delete;
-  static Ptr create(const std::filesystem::path &path);
-  virtual ~MemoryFileAdapter() override;
+  FileDescriptorStream() = delete;
+  static Ptr create(int fd);
+  virtual ~FileDescriptorStream() override;
 
   virtual bool seek(std::uint64_t offset) override;
   virtual std::uint64_t offset() const override;
   virtual bool read(std::uint8_t *buffer, std::size_t size) override;
 
 private:
-  MemoryFileAdapter(std::unique_ptr<char[]> buffer, std::size_t size);
+  FileDescriptorStream(int fd_);
 };
 
 } // namespace btfparse
@@ -55,6 +55,16 @@ std::uint32_t FileReader::u32() { return u32(d->context); }
 
 std::uint64_t FileReader::u64() { return u64(d->context); }
 
+void FileReader::readAt(std::uint64_t offset, std::uint8_t *buffer,
+                        std::size_t size) const {
+  readAt(d->context, offset, buffer, size);
+}
+
+std::optional<ByteSpan> FileReader::view(std::uint64_t offset,
+                                         std::size_t size) const {
+  return view(d->context, offset, size);
+}
+
 FileReader::FileReader(IStream::Ptr stream) : d(new PrivateData) {
   d->context.stream = std::move(stream);
 }
@@ -157,4 +167,29 @@ std::uint64_t FileReader::u64(Context &context) {
   return value;
 }
 
+void FileReader::readAt(const Context &context, std::uint64_t offset,
+                        std::uint8_t *buffer, std::size_t size) {
+  if (!context.stream->readAt(offset, buffer, size)) {
+    throw FileReaderError(
+        {FileReaderErrorInformation::Code::IOError,
+         FileReaderErrorInformation::ReadOperation{offset, size}});
+  }
+}
+
+std::optional<ByteSpan> FileReader::view(const Context &context,
+                                         std::uint64_t offset,
+                                         std::size_t size) {
+  auto opt_stream_view = context.stream->view();
+  if (!opt_stream_view.has_value()) {
+    return std::nullopt;
+  }
+
+  const auto &stream_view = opt_stream_view.value();
+  if (!stream_view.contains(offset, size)) {
+    return std::nullopt;
+  }
+
+  return stream_view.subspan(static_cast<std::size_t>(offset), size);
+}
+
 } // namespace btfparse
@@ -30,6 +30,12 @@ public:
   virtual std::uint32_t u32() override;
   virtual std::uint64_t u64() override;
 
+  virtual void readAt(std::uint64_t offset, std::uint8_t *buffer,
+                      std::size_t size) const override;
+
+  virtual std::optional<ByteSpan> view(std::uint64_t offset,
+                                       std::size_t size) const override;
+
 private:
   struct PrivateData;
   std::unique_ptr<PrivateData> d;
@@ -53,6 +59,12 @@ public:
   static std::uint32_t u32(Context &context);
   static std::uint64_t u64(Context &context);
 
+  static void readAt(const Context &context, std::uint64_t offset,
+                     std::uint8_t *buffer, std::size_t size);
+
+  static std::optional<ByteSpan> view(const Context &context,
+                                      std::uint64_t offset, std::size_t size);
+
   friend class IFileReader;
 };
 
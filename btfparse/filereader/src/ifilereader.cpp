@@ -6,19 +6,54 @@
 // the LICENSE file found in the root directory of this source tree.
 //
 
+#include "compressedfilestream.h"
+#include "elfimage.h"
 #include "filereader.h"
-#include "memoryfileadapter.h"
+#include "mappedfilestream.h"
+#include "memorystream.h"
 
 #include <btfparse/ifilereader.h>
 
 namespace btfparse {
 
+namespace {
+
+const std::string_view kBTFSectionName{".BTF"};
+
+// ELF images are replaced with a stream covering their .BTF section. The
+// section is not copied: the new stream keeps the original one alive
+IStream::Ptr unwrapELFImage(IStream::Ptr stream) {
+  auto opt_view = stream->view();
+  if (!opt_view.has_value() || !ELFImage::isELFImage(opt_view.value())) {
+    return stream;
+  }
+
+  auto section = ELFImage::getSection(opt_view.value(), kBTFSectionName);
+  return MemoryStream::create(section,
+                              std::shared_ptr<IStream>(std::move(stream)));
+}
+
+} // namespace
+
 Result<IFileReader::Ptr, FileReaderError>
 IFileReader::open(const std::filesystem::path &path) noexcept {
-  MemoryFileAdapter::Ptr memoryfile_ptr;
+  IStream::Ptr stream;
 
   try {
-    memoryfile_ptr = MemoryFileAdapter::create(path);
+    stream = MappedFileStream::create(path);
+
+    // Compressed files are only mapped while they are decompressed
+    auto opt_view = stream->view();
+    auto format = opt_view.has_value()
+                      ? IDecompressor::detectFormat(opt_view.value())
+                      : IDecompressor::Format::None;
+
+    if (format != IDecompressor::Format::None) {
+      stream = CompressedFileStream::create(opt_view.value(), format);
+
+    } else {
+      stream = unwrapELFImage(std::move(stream));
+    }
 
   } catch (const std::bad_alloc &) {
     return FileReaderError(FileReaderErrorInformation{
@@ -29,7 +64,7 @@ IFileReader::open(const std::filesystem::path &path) noexcept {
     return e;
   }
 
-  return FileReader::create(std::move(memoryfile_ptr));
+  return FileReader::create(std::move(stream));
 }
 
 Result<IFileReader::Ptr, FileReaderError>
@@ -37,4 +72,35 @@ IFileReader::createFromStream(IStream::Ptr stream) noexcept {
   return FileReader::create(std::move(stream));
 }
 
+Result<IFileReader::Ptr, FileReaderError>
+IFileReader::createFromBuffer(ByteSpan buffer,
+                              std::shared_ptr<const void> owner) noexcept {
+  IStream::Ptr stream;
+
+  try {
+    if (ELFImage::isELFImage(buffer)) {
+      buffer = ELFImage::getSection(buffer, kBTFSectionName);
+    }
+
+    stream = MemoryStream::create(buffer, std::move(owner));
+
+  } catch (const std::bad_alloc &) {
+    return FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+
+  } catch (const FileReaderError &e) {
+    return e;
+  }
+
+  return FileReader::create(std::move(stream));
+}
+
+void IFileReader::readAt(std::uint64_t offset, std::uint8_t *,
+                         std::size_t size) const {
+  throw FileReaderError(
+      {FileReaderErrorInformation::Code::IOError,
+       FileReaderErrorInformation::ReadOperation{offset, size}});
+}
+
 } // namespace btfparse
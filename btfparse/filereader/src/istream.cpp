@@ -0,0 +1,19 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "filedescriptorstream.h"
+
+#include <btfparse/istream.h>
+
+namespace btfparse {
+
+IStream::Ptr IStream::createFromFileDescriptor(int fd) {
+  return FileDescriptorStream::create(fd);
+}
+
+} // namespace btfparse
@@ -0,0 +1,183 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "mappedfilestream.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <btfparse/ifilereader.h>
+
+namespace btfparse {
+
+namespace {
+
+const std::size_t kUnknownSizeReadChunk{64U * 1024U};
+
+struct FileDescriptor final {
+  int fd{-1};
+
+  ~FileDescriptor() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+};
+
+} // namespace
+
+MappedFileStream::MappedFileStream(void *address, std::size_t size)
+    : file_buffer(static_cast<const std::uint8_t *>(address)),
+      file_buffer_size(size), mapped_address(address) {}
+
+MappedFileStream::MappedFileStream(std::vector<std::uint8_t> buffer)
+    : read_buffer(std::move(buffer)) {
+
+  file_buffer = read_buffer.data();
+  file_buffer_size = read_buffer.size();
+}
+
+MappedFileStream::~MappedFileStream() {
+  if (mapped_address != nullptr) {
+    ::munmap(mapped_address, file_buffer_size);
+  }
+}
+
+IStream::Ptr MappedFileStream::create(const std::filesystem::path &path) {
+  try {
+    FileDescriptor file;
+    file.fd = ::open(path.string().c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (file.fd < 0) {
+      throw FileReaderError(FileReaderErrorInformation{
+          FileReaderErrorInformation::Code::FileNotFound});
+    }
+
+    struct stat stat_data {};
+    if (::fstat(file.fd, &stat_data) < 0) {
+      throw FileReaderError(FileReaderErrorInformation{
+          FileReaderErrorInformation::Code::IOError});
+    }
+
+    auto file_size = static_cast<std::size_t>(stat_data.st_size);
+
+    // Regular files are mapped read-only so that multiple processes loading
+    // the same BTF data end up sharing the page cache. Pseudo files (such as
+    // the ones in sysfs) usually can't be mapped, so fall back to reading
+    // the whole file in memory
+    if (S_ISREG(stat_data.st_mode) && file_size != 0) {
+      auto address = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE,
+                            file.fd, 0);
+
+      if (address != MAP_FAILED) {
+        ::madvise(address, file_size, MADV_SEQUENTIAL);
+        ::madvise(address, file_size, MADV_WILLNEED);
+
+        return Ptr(new MappedFileStream(address, file_size));
+      }
+    }
+
+    auto buffer = readFile(file.fd, file_size);
+    return Ptr(new MappedFileStream(std::move(buffer)));
+
+  } catch (const std::bad_alloc &) {
+    throw FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::MemoryAllocationFailure,
+    });
+  }
+}
+
+bool MappedFileStream::seek(std::uint64_t offset) {
+  if (offset >= file_buffer_size) {
+    return false;
+  }
+
+  file_pos = static_cast<std::size_t>(offset);
+
+  return true;
+}
+
+std::uint64_t MappedFileStream::offset() const {
+  return static_cast<std::uint64_t>(file_pos);
+}
+
+bool MappedFileStream::read(std::uint8_t *buffer, std::size_t size) {
+  if (!readAt(file_pos, buffer, size)) {
+    return false;
+  }
+
+  file_pos += size;
+
+  return true;
+}
+
+bool MappedFileStream::readAt(std::uint64_t offset, std::uint8_t *buffer,
+                              std::size_t size) const {
+  if (!ByteSpan(file_buffer, file_buffer_size).contains(offset, size)) {
+    return false;
+  }
+
+  std::memcpy(buffer, file_buffer + offset, size);
+
+  return true;
+}
+
+std::optional<ByteSpan> MappedFileStream::view() const {
+  return ByteSpan(file_buffer, file_buffer_size);
+}
+
+std::vector<std::uint8_t> MappedFileStream::readFile(int fd,
+                                                     std::size_t size_hint) {
+  // When the size is known, this is a single large read; the loop only
+  // handles short reads and files that report a size of zero
+  std::vector<std::uint8_t> buffer(size_hint != 0 ? size_hint
+                                                  : kUnknownSizeReadChunk);
+
+  std::size_t pos{0};
+
+  for (;;) {
+    if (pos == buffer.size()) {
+      if (size_hint != 0) {
+        break;
+      }
+
+      buffer.resize(buffer.size() + kUnknownSizeReadChunk);
+    }
+
+    auto read_res = ::read(fd, buffer.data() + pos, buffer.size() - pos);
+    if (read_res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw FileReaderError(FileReaderErrorInformation{
+          FileReaderErrorInformation::Code::IOError});
+    }
+
+    if (read_res == 0) {
+      break;
+    }
+
+    pos += static_cast<std::size_t>(read_res);
+  }
+
+  if (size_hint != 0 && pos != size_hint) {
+    throw FileReaderError(FileReaderErrorInformation{
+        FileReaderErrorInformation::Code::IOError});
+  }
+
+  buffer.resize(pos);
+  return buffer;
+}
+
+} // namespace btfparse
@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/istream.h>
+
+#include <filesystem>
+#include <vector>
+
+namespace btfparse {
+
+class MappedFileStream final : public IStream {
+private:
+  const std::uint8_t *file_buffer{nullptr};
+  std::size_t file_buffer_size{0};
+  std::size_t file_pos{0};
+
+  void *mapped_address{nullptr};
+  std::vector<std::uint8_t> read_buffer;
+
+public:
+  MappedFileStream() = delete;
+  static Ptr create(const std::filesystem::path &path);
+  virtual ~MappedFileStream() override;
+
+  virtual bool seek(std::uint64_t offset) override;
+  virtual std::uint64_t offset() const override;
+  virtual bool read(std::uint8_t *buffer, std::size_t size) override;
+  virtual bool readAt(std::uint64_t offset, std::uint8_t *buffer,
+                      std::size_t size) const override;
+  virtual std::optional<ByteSpan> view() const override;
+
+private:
+  MappedFileStream(void *address, std::size_t size);
+  MappedFileStream(std::vector<std::uint8_t> buffer);
+
+  static std::vector<std::uint8_t> readFile(int fd, std::size_t size_hint);
+};
+
+} // namespace btfparse
@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#include "memorystream.h"
+
+#include <cstring>
+
+namespace btfparse {
+
+MemoryStream::MemoryStream(ByteSpan buffer_,
+                           std::shared_ptr<const void> owner)
+    : buffer(buffer_), buffer_owner(std::move(owner)) {}
+
+MemoryStream::~MemoryStream() {}
+
+IStream::Ptr MemoryStream::create(ByteSpan buffer,
+                                  std::shared_ptr<const void> owner) {
+  return Ptr(new MemoryStream(buffer, std::move(owner)));
+}
+
+bool MemoryStream::seek(std::uint64_t offset) {
+  if (offset >= buffer.size()) {
+    return false;
+  }
+
+  buffer_pos = static_cast<std::size_t>(offset);
+
+  return true;
+}
+
+std::uint64_t MemoryStream::offset() const {
+  return static_cast<std::uint64_t>(buffer_pos);
+}
+
+bool MemoryStream::read(std::uint8_t *destination, std::size_t size) {
+  if (!readAt(buffer_pos, destination, size)) {
+    return false;
+  }
+
+  buffer_pos += size;
+
+  return true;
+}
+
+bool MemoryStream::readAt(std::uint64_t offset, std::uint8_t *destination,
+                          std::size_t size) const {
+  if (!buffer.contains(offset, size)) {
+    return false;
+  }
+
+  std::memcpy(destination, buffer.data() + offset, size);
+
+  return true;
+}
+
+std::optional<ByteSpan> MemoryStream::view() const { return buffer; }
+
+} // namespace btfparse
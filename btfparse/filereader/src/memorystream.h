@@ -0,0 +1,37 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <btfparse/istream.h>
+
+namespace btfparse {
+
+class MemoryStream final : public IStream {
+private:
+  ByteSpan buffer;
+  std::size_t buffer_pos{0};
+  std::shared_ptr<const void> buffer_owner;
+
+public:
+  MemoryStream() = delete;
+  static Ptr create(ByteSpan buffer, std::shared_ptr<const void> owner);
+  virtual ~MemoryStream() override;
+
+  virtual bool seek(std::uint64_t offset) override;
+  virtual std::uint64_t offset() const override;
+  virtual bool read(std::uint8_t *buffer, std::size_t size) override;
+  virtual bool readAt(std::uint64_t offset, std::uint8_t *buffer,
+                      std::size_t size) const override;
+  virtual std::optional<ByteSpan> view() const override;
+
+private:
+  MemoryStream(ByteSpan buffer_, std::shared_ptr<const void> owner);
+};
+
+} // namespace btfparse
@@ -6,12 +6,34 @@
 // the LICENSE file found in the root directory of this source tree.
 //
 
+#include "compressedfilestream.h"
+#include "elfimage.h"
 #include "filereader.h"
+#include "mappedfilestream.h"
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef BTFPARSE_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef BTFPARSE_HAVE_XZ
+#include <lzma.h>
+#endif
+
+#ifdef BTFPARSE_HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 namespace btfparse {
 
@@ -46,11 +68,142 @@ public:
     return true;
   }
 
+  virtual bool readAt(std::uint64_t offset, std::uint8_t *buffer,
+                      std::size_t size) const override {
+    if (fail_reads) {
+      return false;
+    }
+
+    for (std::size_t i = 0; i < size; ++i) {
+      buffer[i] = static_cast<std::uint8_t>(offset + i);
+    }
+
+    return true;
+  }
+
   bool fail_seeks{false};
   bool fail_reads{false};
   std::uint64_t current_offset{};
 };
 
+using SectionList = std::vector<std::pair<std::string, std::string>>;
+
+// Builds a minimal little endian ELF64 image with a section string table
+// followed by the given sections. The section headers are placed at the
+// end, or right after the ELF header when `section_table_first` is set
+std::vector<std::uint8_t> buildELFImage(const SectionList &section_list,
+                                        bool section_table_first = false) {
+  std::string string_table{'\0'};
+  string_table += ".shstrtab";
+  string_table += '\0';
+
+  std::vector<std::uint32_t> section_name_offset_list;
+  for (const auto &section : section_list) {
+    section_name_offset_list.push_back(
+        static_cast<std::uint32_t>(string_table.size()));
+
+    string_table += section.first;
+    string_table += '\0';
+  }
+
+  const std::size_t kHeaderSize{0x40U};
+  const std::size_t kSectionHeaderSize{0x40U};
+
+  auto section_count = section_list.size() + 2;
+  auto section_table_size = section_count * kSectionHeaderSize;
+
+  auto string_table_offset = kHeaderSize;
+  if (section_table_first) {
+    string_table_offset += section_table_size;
+  }
+
+  std::vector<std::size_t> section_data_offset_list;
+  auto section_data_offset = string_table_offset + string_table.size();
+
+  for (const auto &section : section_list) {
+    section_data_offset_list.push_back(section_data_offset);
+    section_data_offset += section.second.size();
+  }
+
+  auto section_table_offset =
+      section_table_first ? kHeaderSize : section_data_offset;
+
+  std::vector<std::uint8_t> image(section_data_offset + section_table_size);
+
+  auto write = [&image](std::size_t offset, std::uint64_t value,
+                        std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+      image[offset + i] = static_cast<std::uint8_t>(value >> (i * 8));
+    }
+  };
+
+  image[0] = 0x7F;
+  image[1] = 'E';
+  image[2] = 'L';
+  image[3] = 'F';
+  image[4] = 2;
+  image[5] = 1;
+  image[6] = 1;
+
+  write(0x28, section_table_offset, 8);
+  write(0x3A, kSectionHeaderSize, 2);
+  write(0x3C, section_count, 2);
+  write(0x3E, 1, 2);
+
+  std::memcpy(image.data() + string_table_offset, string_table.data(),
+              string_table.size());
+
+  auto shstrtab_header = section_table_offset + kSectionHeaderSize;
+  write(shstrtab_header, 1, 4);
+  write(shstrtab_header + 4, 3, 4);
+  write(shstrtab_header + 0x18, string_table_offset, 8);
+  write(shstrtab_header + 0x20, string_table.size(), 8);
+
+  for (std::size_t i = 0; i < section_list.size(); ++i) {
+    const auto &section_data = section_list[i].second;
+
+    std::memcpy(image.data() + section_data_offset_list[i],
+                section_data.data(), section_data.size());
+
+    auto section_header = shstrtab_header + ((i + 1) * kSectionHeaderSize);
+    write(section_header, section_name_offset_list[i], 4);
+    write(section_header + 4, 1, 4);
+    write(section_header + 0x18, section_data_offset_list[i], 8);
+    write(section_header + 0x20, section_data.size(), 8);
+  }
+
+  return image;
+}
+
+std::vector<std::uint8_t> buildELFImage(const std::string &section_name,
+                                        const std::string &section_data) {
+  return buildELFImage(SectionList{{section_name, section_data}});
+}
+
+// Moves the section count of the image into the first section header, as
+// is done for images with too many sections
+void setExtendedSectionCount(std::vector<std::uint8_t> &image) {
+  std::uint64_t section_table_offset{};
+  std::memcpy(&section_table_offset, image.data() + 0x28, 8);
+
+  std::memcpy(image.data() + section_table_offset + 0x20, image.data() + 0x3C,
+              2);
+
+  image[0x3C] = 0;
+  image[0x3D] = 0;
+}
+
+std::optional<FileReaderErrorInformation::Code>
+getSectionErrorCode(const std::vector<std::uint8_t> &image) {
+  try {
+    ELFImage::getSection(ByteSpan(image.data(), image.size()), ".BTF");
+  } catch (const FileReaderError &error) {
+    return error.get().code;
+  }
+
+  return std::nullopt;
+}
+
 TEST_CASE("FileReader::setEndianness()") {
   FileReader::Context context;
   context.little_endian = true;
@@ -128,6 +281,116 @@ TEST_CASE("FileReader::read()") {
   CHECK(read_operation.size == 1);
 }
 
+TEST_CASE("FileReader::readAt()") {
+  FileReader::Context context;
+  context.stream = std::make_unique<MockedStream>();
+
+  auto &mocked_stream = *static_cast<MockedStream *>(context.stream.get());
+  mocked_stream.current_offset = 3;
+
+  std::array<std::uint8_t, 4> read_buffer;
+
+  FileReader::readAt(context, 10, read_buffer.data(), read_buffer.size());
+  CHECK(read_buffer[0] == 10);
+  CHECK(read_buffer[3] == 13);
+  CHECK(FileReader::offset(context) == 3);
+
+  mocked_stream.fail_reads = true;
+  std::optional<FileReaderError> opt_file_reader_error;
+
+  try {
+    FileReader::readAt(context, 20, read_buffer.data(), 2);
+  } catch (FileReaderError error) {
+    opt_file_reader_error = std::move(error);
+  }
+
+  REQUIRE(opt_file_reader_error.has_value());
+
+  const auto &error_information = opt_file_reader_error.value().get();
+  REQUIRE(error_information.opt_read_operation.has_value());
+
+  const auto &read_operation = error_information.opt_read_operation.value();
+  CHECK(read_operation.offset == 20);
+  CHECK(read_operation.size == 2);
+}
+
+TEST_CASE("IStream::readAt()") {
+  // Only implements the sequential primitives, like streams written before
+  // readAt() was added
+  class SequentialStream final : public IStream {
+  public:
+    SequentialStream() = default;
+    virtual ~SequentialStream() override = default;
+
+    virtual bool seek(std::uint64_t offset) override {
+      current_offset = offset;
+      return true;
+    }
+
+    virtual std::uint64_t offset() const override { return current_offset; }
+
+    virtual bool read(std::uint8_t *buffer, std::size_t size) override {
+      std::memset(buffer, 0, size);
+
+      current_offset += size;
+      return true;
+    }
+
+  private:
+    std::uint64_t current_offset{};
+  };
+
+  // The default implementation fails without touching the stream offset
+  SequentialStream stream;
+  REQUIRE(stream.seek(3));
+
+  std::array<std::uint8_t, 4> read_buffer;
+  CHECK(!stream.readAt(10, read_buffer.data(), read_buffer.size()));
+  CHECK(stream.offset() == 3);
+  CHECK(!stream.view().has_value());
+}
+
+TEST_CASE("IFileReader::readAt(), IFileReader::view()") {
+  // Only implements the methods that every reader had to provide before
+  // readAt() and view() were added
+  class SequentialFileReader final : public IFileReader {
+  public:
+    SequentialFileReader() = default;
+    virtual ~SequentialFileReader() override = default;
+
+    virtual void setEndianness(bool) override {}
+    virtual void seek(std::uint64_t) override {}
+    virtual std::uint64_t offset() const override { return 0; }
+    virtual void read(std::uint8_t *, std::size_t) override {}
+    virtual std::uint8_t u8() override { return 0; }
+    virtual std::uint16_t u16() override { return 0; }
+    virtual std::uint32_t u32() override { return 0; }
+    virtual std::uint64_t u64() override { return 0; }
+  };
+
+  SequentialFileReader file_reader;
+  CHECK(!file_reader.view(0, 4).has_value());
+
+  std::optional<FileReaderError> opt_file_reader_error;
+
+  try {
+    std::array<std::uint8_t, 4> read_buffer;
+    file_reader.readAt(10, read_buffer.data(), read_buffer.size());
+
+  } catch (FileReaderError error) {
+    opt_file_reader_error = std::move(error);
+  }
+
+  REQUIRE(opt_file_reader_error.has_value());
+
+  const auto &error_information = opt_file_reader_error.value().get();
+  CHECK(error_information.code == FileReaderErrorInformation::Code::IOError);
+
+  REQUIRE(error_information.opt_read_operation.has_value());
+  CHECK(error_information.opt_read_operation.value().offset == 10);
+  CHECK(error_information.opt_read_operation.value().size == 4);
+}
+
 TEST_CASE("FileReader::u8()") {
   FileReader::Context context;
   context.stream = std::make_unique<MockedStream>();
@@ -175,4 +438,461 @@ TEST_CASE("FileReader::u64()") {
   CHECK(value == 0xFF00000000000000ULL);
 }
 
+TEST_CASE("FileReader::view()") {
+  FileReader::Context context;
+  context.stream = std::make_unique<MockedStream>();
+
+  CHECK(!FileReader::view(context, 0, 1).has_value());
+
+  auto path = std::filesystem::temp_directory_path() /
+              "btfparse-filereader-tests-view";
+
+  {
+    std::ofstream output(path, std::ios::binary);
+    output << "0123456789";
+  }
+
+  context.stream = MappedFileStream::create(path);
+  std::filesystem::remove(path);
+
+  auto opt_view = FileReader::view(context, 2, 8);
+  REQUIRE(opt_view.has_value());
+  CHECK(opt_view.value().size() == 8);
+  CHECK(opt_view.value()[0] == '2');
+
+  CHECK(!FileReader::view(context, 2, 9).has_value());
+  CHECK(!FileReader::view(context, 11, 0).has_value());
+}
+
+TEST_CASE("MappedFileStream::create()") {
+  auto path = std::filesystem::temp_directory_path() /
+              "btfparse-filereader-tests-mappedfilestream";
+
+  {
+    std::ofstream output(path, std::ios::binary);
+    output << "0123456789";
+  }
+
+  auto stream = MappedFileStream::create(path);
+  std::filesystem::remove(path);
+
+  std::array<std::uint8_t, 4> read_buffer{};
+  CHECK(stream->read(read_buffer.data(), read_buffer.size()));
+  CHECK(read_buffer[0] == '0');
+  CHECK(read_buffer[3] == '3');
+  CHECK(stream->offset() == 4);
+
+  CHECK(stream->seek(8));
+  CHECK(!stream->read(read_buffer.data(), read_buffer.size()));
+  CHECK(stream->read(read_buffer.data(), 2));
+  CHECK(read_buffer[1] == '9');
+
+  CHECK(!stream->seek(10));
+
+  CHECK(stream->readAt(1, read_buffer.data(), 2));
+  CHECK(read_buffer[0] == '1');
+  CHECK(stream->offset() == 10);
+  CHECK(stream->readAt(6, read_buffer.data(), 4));
+  CHECK(!stream->readAt(7, read_buffer.data(), 4));
+
+  std::optional<FileReaderError> opt_file_reader_error;
+
+  try {
+    MappedFileStream::create(path);
+  } catch (FileReaderError error) {
+    opt_file_reader_error = std::move(error);
+  }
+
+  REQUIRE(opt_file_reader_error.has_value());
+
+  const auto &error_information = opt_file_reader_error.value().get();
+  CHECK(error_information.code ==
+        FileReaderErrorInformation::Code::FileNotFound);
+}
+
+TEST_CASE("ELFImage::getSection()") {
+  auto image = buildELFImage(".BTF", "btf-data");
+  ByteSpan image_span(image.data(), image.size());
+
+  CHECK(ELFImage::isELFImage(image_span));
+  CHECK(!ELFImage::isELFImage(image_span.subspan(1, image.size() - 1)));
+
+  auto section = ELFImage::getSection(image_span, ".BTF");
+  REQUIRE(section.size() == 8);
+  CHECK(std::memcmp(section.data(), "btf-data", 8) == 0);
+
+  CHECK(getSectionErrorCode(buildELFImage(".BTF.ext", "data")) ==
+        FileReaderErrorInformation::Code::SectionNotFound);
+
+  setExtendedSectionCount(image);
+  CHECK(ELFImage::getSection(image_span, ".BTF").size() == 8);
+
+  image.resize(image.size() - 0x40);
+  CHECK(getSectionErrorCode(image) ==
+        FileReaderErrorInformation::Code::InvalidELFImage);
+}
+
+TEST_CASE("IFileReader::createFromBuffer() with an ELF image") {
+  auto image = std::make_shared<std::vector<std::uint8_t>>(
+      buildELFImage(".BTF", "\x01\x02\x03\x04"));
+
+  auto file_reader_res = IFileReader::createFromBuffer(
+      ByteSpan(image->data(), image->size()), image);
+
+  REQUIRE(!file_reader_res.failed());
+
+  auto file_reader = file_reader_res.takeValue();
+  file_reader->setEndianness(true);
+
+  CHECK(file_reader->u32() == 0x04030201U);
+
+  auto opt_view = file_reader->view(0, 4);
+  REQUIRE(opt_view.has_value());
+
+  // The section must be referenced in place, not copied
+  auto view_address = opt_view.value().data();
+  CHECK(view_address > image->data());
+  CHECK(view_address < image->data() + image->size());
+}
+
+TEST_CASE("IDecompressor::detectFormat()") {
+  const std::uint8_t kGzipHeader[]{0x1F, 0x8B, 0x08, 0x00};
+  const std::uint8_t kXzHeader[]{0xFD, '7', 'z', 'X', 'Z', 0x00};
+  const std::uint8_t kZstdHeader[]{0x28, 0xB5, 0x2F, 0xFD};
+  const std::uint8_t kELFHeader[]{0x7F, 'E', 'L', 'F'};
+
+  CHECK(IDecompressor::detectFormat(ByteSpan(kGzipHeader, 4)) ==
+        IDecompressor::Format::Gzip);
+
+  CHECK(IDecompressor::detectFormat(ByteSpan(kXzHeader, 6)) ==
+        IDecompressor::Format::Xz);
+
+  CHECK(IDecompressor::detectFormat(ByteSpan(kXzHeader, 5)) ==
+        IDecompressor::Format::None);
+
+  CHECK(IDecompressor::detectFormat(ByteSpan(kZstdHeader, 4)) ==
+        IDecompressor::Format::Zstd);
+
+  CHECK(IDecompressor::detectFormat(ByteSpan(kELFHeader, 4)) ==
+        IDecompressor::Format::None);
+}
+
+TEST_CASE("CompressedFileStream::getBTFSize()") {
+  std::array<std::uint8_t, CompressedFileStream::kBTFHeaderSize> header{
+      0x9F, 0xEB, 1, 0, 24, 0, 0, 0, 0, 0, 0, 0,
+      16,   0,    0, 0, 16, 0, 0, 0, 5, 0, 0, 0};
+
+  CHECK(CompressedFileStream::getBTFSize(header.data()) == 24U + 16U + 5U);
+
+  std::array<std::uint8_t, CompressedFileStream::kBTFHeaderSize>
+      big_endian_header{0xEB, 0x9F, 1, 0, 0, 0, 0, 24, 0, 0, 0, 0,
+                        0,    0,    0, 8, 0, 0, 0, 8,  0, 0, 0, 1};
+
+  CHECK(CompressedFileStream::getBTFSize(big_endian_header.data()) ==
+        24U + 8U + 1U);
+
+  // The string section must immediately follow the type section
+  header[16] = 20;
+  CHECK(!CompressedFileStream::getBTFSize(header.data()).has_value());
+
+  // .BTF.ext sections share the magic value but have a longer header
+  header[16] = 16;
+  header[4] = 32;
+  CHECK(!CompressedFileStream::getBTFSize(header.data()).has_value());
+}
+
+#if defined(BTFPARSE_HAVE_ZLIB) || defined(BTFPARSE_HAVE_XZ) ||             \
+    defined(BTFPARSE_HAVE_ZSTD)
+const std::uint8_t kBTFData[]{0x9F, 0xEB, 1, 0, 24, 0, 0, 0, 0, 0,   0,
+                              0,    4,    0, 0, 0,  4, 0, 0, 0, 3,   0,
+                              0,    0,    1, 2, 3,  4, 0, 'a', 0};
+
+// The formats whose support has been compiled in
+const std::vector<IDecompressor::Format> kFormatList{
+#ifdef BTFPARSE_HAVE_ZLIB
+    IDecompressor::Format::Gzip,
+#endif
+
+#ifdef BTFPARSE_HAVE_XZ
+    IDecompressor::Format::Xz,
+#endif
+
+#ifdef BTFPARSE_HAVE_ZSTD
+    IDecompressor::Format::Zstd,
+#endif
+};
+
+#ifdef BTFPARSE_HAVE_ZLIB
+std::vector<std::uint8_t> gzipCompress(const std::vector<std::uint8_t> &data) {
+  z_stream stream{};
+  REQUIRE(deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8,
+                       Z_DEFAULT_STRATEGY) == Z_OK);
+
+  std::vector<std::uint8_t> compressed_data(
+      deflateBound(&stream, static_cast<uLong>(data.size())));
+
+  stream.next_in = const_cast<std::uint8_t *>(data.data());
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_out = compressed_data.data();
+  stream.avail_out = static_cast<uInt>(compressed_data.size());
+
+  REQUIRE(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+  compressed_data.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  return compressed_data;
+}
+#endif
+
+#ifdef BTFPARSE_HAVE_XZ
+std::vector<std::uint8_t> xzCompress(const std::vector<std::uint8_t> &data) {
+  std::vector<std::uint8_t> compressed_data(
+      lzma_stream_buffer_bound(data.size()));
+
+  std::size_t compressed_size{0};
+  REQUIRE(lzma_easy_buffer_encode(0, LZMA_CHECK_CRC64, nullptr, data.data(),
+                                  data.size(), compressed_data.data(),
+                                  &compressed_size,
+                                  compressed_data.size()) == LZMA_OK);
+
+  compressed_data.resize(compressed_size);
+  return compressed_data;
+}
+#endif
+
+#ifdef BTFPARSE_HAVE_ZSTD
+std::vector<std::uint8_t> zstdCompress(const std::vector<std::uint8_t> &data) {
+  std::vector<std::uint8_t> compressed_data(ZSTD_compressBound(data.size()));
+
+  auto compressed_size =
+      ZSTD_compress(compressed_data.data(), compressed_data.size(),
+                    data.data(), data.size(), 1);
+
+  REQUIRE(!ZSTD_isError(compressed_size));
+
+  compressed_data.resize(compressed_size);
+  return compressed_data;
+}
+#endif
+
+std::vector<std::uint8_t> compress(IDecompressor::Format format,
+                                   const std::vector<std::uint8_t> &data) {
+  switch (format) {
+#ifdef BTFPARSE_HAVE_ZLIB
+  case IDecompressor::Format::Gzip:
+    return gzipCompress(data);
+#endif
+
+#ifdef BTFPARSE_HAVE_XZ
+  case IDecompressor::Format::Xz:
+    return xzCompress(data);
+#endif
+
+#ifdef BTFPARSE_HAVE_ZSTD
+  case IDecompressor::Format::Zstd:
+    return zstdCompress(data);
+#endif
+
+  default:
+    break;
+  }
+
+  FAIL("Unsupported compression format");
+  return {};
+}
+
+// Compresses the data and opens it through a temporary file
+Result<IFileReader::Ptr, FileReaderError>
+openCompressedData(IDecompressor::Format format,
+                   const std::vector<std::uint8_t> &data) {
+  auto compressed_data = compress(format, data);
+
+  auto path = std::filesystem::temp_directory_path() /
+              "btfparse-filereader-tests-compressed";
+
+  {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(reinterpret_cast<const char *>(compressed_data.data()),
+                 static_cast<std::streamsize>(compressed_data.size()));
+  }
+
+  CHECK(IDecompressor::detectFormat(ByteSpan(compressed_data.data(),
+                                             compressed_data.size())) ==
+        format);
+
+  auto file_reader_res = IFileReader::open(path);
+  std::filesystem::remove(path);
+
+  return file_reader_res;
+}
+
+void checkBTFData(Result<IFileReader::Ptr, FileReaderError> file_reader_res) {
+  REQUIRE(!file_reader_res.failed());
+
+  auto file_reader = file_reader_res.takeValue();
+  auto opt_view = file_reader->view(0, sizeof(kBTFData));
+
+  REQUIRE(opt_view.has_value());
+  CHECK(std::memcmp(opt_view.value().data(), kBTFData, sizeof(kBTFData)) == 0);
+  CHECK(!file_reader->view(0, sizeof(kBTFData) + 1).has_value());
+}
+
+std::optional<FileReaderErrorInformation::Code>
+getErrorCode(Result<IFileReader::Ptr, FileReaderError> file_reader_res) {
+  if (!file_reader_res.failed()) {
+    return std::nullopt;
+  }
+
+  return file_reader_res.error().get().code;
+}
+
+TEST_CASE("IDecompressor::decompress()") {
+  std::vector<std::uint8_t> data(256U * 1024U);
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<std::uint8_t>((i * 7U) ^ (i >> 9U));
+  }
+
+  for (auto format : kFormatList) {
+    auto compressed_data = compress(format, data);
+    auto decompressor = IDecompressor::create(format);
+
+    // Feed the input and collect the output in small pieces, so that the
+    // decompressor has to stop and resume many times
+    const std::size_t kInputChunkSize{97U};
+    const std::size_t kOutputChunkSize{251U};
+
+    std::vector<std::uint8_t> decompressed_data;
+    std::size_t input_offset{0};
+    ByteSpan input;
+
+    while (!decompressor->finished()) {
+      if (input.empty() && input_offset < compressed_data.size()) {
+        auto input_size =
+            std::min(kInputChunkSize, compressed_data.size() - input_offset);
+
+        input = ByteSpan(compressed_data.data() + input_offset, input_size);
+        input_offset += input_size;
+      }
+
+      auto output_offset = decompressed_data.size();
+      decompressed_data.resize(output_offset + kOutputChunkSize);
+
+      auto output_size = decompressor->decompress(
+          input, decompressed_data.data() + output_offset, kOutputChunkSize);
+
+      decompressed_data.resize(output_offset + output_size);
+
+      if (output_size == 0 && input.empty() &&
+          input_offset == compressed_data.size()) {
+        break;
+      }
+    }
+
+    CHECK(decompressor->finished());
+    CHECK(decompressed_data == data);
+
+    // Corrupted streams must fail
+    compressed_data.assign(data.begin(), data.begin() + 1024U);
+    decompressor = IDecompressor::create(format);
+
+    std::optional<FileReaderError> opt_file_reader_error;
+
+    try {
+      input = ByteSpan(compressed_data.data(), compressed_data.size());
+
+      std::array<std::uint8_t, 1024U> output_buffer;
+      while (!input.empty()) {
+        decompressor->decompress(input, output_buffer.data(),
+                                 output_buffer.size());
+      }
+
+    } catch (FileReaderError error) {
+      opt_file_reader_error = std::move(error);
+    }
+
+    REQUIRE(opt_file_reader_error.has_value());
+    CHECK(opt_file_reader_error.value().get().code ==
+          FileReaderErrorInformation::Code::DecompressionError);
+  }
+}
+
+TEST_CASE("CompressedFileStream::create()") {
+  for (auto format : kFormatList) {
+    // Keep enough data after the BTF blob so that the tail of the file is
+    // never decompressed
+    std::vector<std::uint8_t> uncompressed_data(1024U * 1024U, 0x55);
+    std::memcpy(uncompressed_data.data(), kBTFData, sizeof(kBTFData));
+
+    checkBTFData(openCompressedData(format, uncompressed_data));
+
+    // Truncated streams that never reach the end of the BTF data must fail
+    uncompressed_data.resize(sizeof(kBTFData) - 1);
+
+    CHECK(getErrorCode(openCompressedData(format, uncompressed_data)) ==
+          FileReaderErrorInformation::Code::DecompressionError);
+
+    // Raw BTF data must start with its header
+    uncompressed_data.assign(64U, 0x55);
+    uncompressed_data.insert(uncompressed_data.end(), std::begin(kBTFData),
+                             std::end(kBTFData));
+
+    CHECK(getErrorCode(openCompressedData(format, uncompressed_data)) ==
+          FileReaderErrorInformation::Code::SectionNotFound);
+  }
+}
+
+TEST_CASE("CompressedFileStream::create() with an ELF image") {
+  std::string btf_section(reinterpret_cast<const char *>(kBTFData),
+                          sizeof(kBTFData));
+
+  // The .BTF.ext section comes first, and starts with a header that would
+  // also pass as a BTF header
+  auto btf_ext_section = btf_section;
+  btf_ext_section[24] = 5;
+
+  // Sized so that the .BTF header starts 10 bytes before the end of a 64 KiB
+  // chunk of decompressed data, and continues in the next one
+  std::string data_section(512U * 1024U - 72U, 'x');
+
+  for (auto format : kFormatList) {
+    auto image = buildELFImage(SectionList{{".BTF.ext", btf_ext_section},
+                                           {".data", data_section},
+                                           {".BTF", btf_section}});
+
+    checkBTFData(openCompressedData(format, image));
+
+    // The section count is read from the first section header when the ELF
+    // header does not hold it
+    setExtendedSectionCount(image);
+    checkBTFData(openCompressedData(format, image));
+
+    // Images that end before their section headers must fail
+    image.resize(image.size() - 1);
+
+    CHECK(getErrorCode(openCompressedData(format, image)) ==
+          FileReaderErrorInformation::Code::DecompressionError);
+
+    image = buildELFImage(".BTF.ext", btf_ext_section);
+
+    CHECK(getErrorCode(openCompressedData(format, image)) ==
+          FileReaderErrorInformation::Code::SectionNotFound);
+
+    // .BTF and the section names may also follow the section headers
+    image = buildELFImage(SectionList{{".BTF.ext", btf_ext_section},
+                                      {".BTF", btf_section}},
+                          true);
+
+    checkBTFData(openCompressedData(format, image));
+
+    // The image is read in a single pass, so a .BTF section that comes
+    // before the section headers is only kept if it starts with a BTF
+    // header
+    image = buildELFImage(SectionList{{".BTF", std::string(64U, 'x')}});
+
+    CHECK(getErrorCode(openCompressedData(format, image)) ==
+          FileReaderErrorInformation::Code::SectionNotFound);
+  }
+}
+#endif
+
 } // namespace btfparse
@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2021-present, Trail of Bits, Inc.
+// All rights reserved.
+//
+// This source code is licensed in accordance with the terms specified in
+// the LICENSE file found in the root directory of this source tree.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace btfparse {
+
+class ByteSpan final {
+  const std::uint8_t *buffer{nullptr};
+  std::size_t buffer_size{0};
+
+public:
+  ByteSpan() = default;
+
+  ByteSpan(const std::uint8_t *data, std::size_t size) noexcept
+      : buffer(data), buffer_size(size) {}
+
+  const std::uint8_t *data() const noexcept { return buffer; }
+  std::size_t size() const noexcept { return buffer_size; }
+  bool empty() const noexcept { return buffer_size == 0; }
+
+  const std::uint8_t *begin() const noexcept { return buffer; }
+  const std::uint8_t *end() const noexcept { return buffer + buffer_size; }
+
+  const std::uint8_t &operator[](std::size_t index) const noexcept {
+    return buffer[index];
+  }
+
+  bool contains(std::uint64_t offset, std::size_t size) const noexcept {
+    return offset <= buffer_size && size <= buffer_size - offset;
+  }
+
+  ByteSpan subspan(std::size_t offset, std::size_t size) const noexcept {
+    return ByteSpan(buffer + offset, size);
+  }
+};
+
+} // namespace btfparse
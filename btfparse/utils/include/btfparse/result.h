@@ -110,7 +110,7 @@ private:
       break;
     }
 
-    if (use_exceptions) {
+    if constexpr (use_exceptions) {
       throw std::logic_error(message);
 
     } else {
@@ -160,8 +160,10 @@ private:
     verifyAccess(std::is_same_v<Type, Value>);
     auto output = std::move(std::get<Type>(data));
 
+    // emplace() rather than an assignment: GCC 12 reports a spurious
+    // -Wfree-nonheap-object for the latter once take() is inlined
     checked = false;
-    data = std::monostate();
+    data.template emplace<std::monostate>();
 
     return output;
   }
@@ -22,6 +22,11 @@ endif()
 
 option(BTFPARSE_ENABLE_TOOLS "Set to ON to build the tools" false)
 option(BTFPARSE_ENABLE_TESTS "Set to ON to build the tests" false)
+option(BTFPARSE_ENABLE_BENCHMARKS "Set to ON to build the benchmarks" false)
+option(BTFPARSE_ENABLE_GZIP "Set to ON to support gzip-compressed input files (requires zlib)" true)
+option(BTFPARSE_ENABLE_XZ "Set to ON to support xz-compressed input files (requires liblzma)" true)
+option(BTFPARSE_ENABLE_ZSTD "Set to ON to support zstd-compressed input files (requires libzstd)" true)
+option(BTFPARSE_REQUIRE_COMPRESSION_LIBRARIES "Set to ON to fail the configuration when an enabled compression library is missing" false)
 option(BTFPARSE_OMIT_FRAME_POINTERS "Set to ON to omit frame pointers" false)
 option(BTFPARSE_ENABLE_SANITIZERS "Set to ON to enable sanitizers" false)
 
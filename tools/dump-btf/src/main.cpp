@@ -10,12 +10,15 @@
 
 #include <cstring>
 
+#include <unistd.h>
+
 namespace {
 
 void showHelp() {
   std::cerr << "Usage:\n"
             << "\tdump-btf /sys/kernel/btf/vmlinux\n"
-            << "\tdump-btf /sys/kernel/btf/vmlinux [/sys/kernel/btf/btusb]\n";
+            << "\tdump-btf /sys/kernel/btf/vmlinux [/sys/kernel/btf/btusb]\n"
+            << "\tcat /sys/kernel/btf/vmlinux | dump-btf -\n";
 }
 
 } // namespace
@@ -26,13 +29,22 @@ int main(int argc, char *argv[]) {
     return 0;
   }
 
-  std::vector<std::filesystem::path> path_list;
-  for (int i = 1; i < argc; ++i) {
-    const char *input_path = argv[i];
-    path_list.emplace_back(input_path);
+  btfparse::Result<btfparse::IBTF::Ptr, btfparse::BTFError> btf_res;
+
+  if (argc == 2 && std::strcmp(argv[1], "-") == 0) {
+    auto stream = btfparse::IStream::createFromFileDescriptor(STDIN_FILENO);
+    btf_res = btfparse::IBTF::createFromStream(*stream);
+
+  } else {
+    std::vector<std::filesystem::path> path_list;
+    for (int i = 1; i < argc; ++i) {
+      const char *input_path = argv[i];
+      path_list.emplace_back(input_path);
+    }
+
+    btf_res = btfparse::IBTF::createFromPathList(path_list);
   }
 
-  auto btf_res = btfparse::IBTF::createFromPathList(path_list);
   if (btf_res.failed()) {
     std::cerr << "Failed to open the BTF file: " << btf_res.takeError() << "\n";
     return 1;
@@ -44,12 +56,19 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  for (const auto &btf_type_map_p : btf->getAll()) {
-    const auto &id = btf_type_map_p.first;
-    const auto &btf_type = btf_type_map_p.second;
+  auto opt_error = btf->forEach(
+      [](std::uint32_t id, const btfparse::BTFType &btf_type) -> bool {
+        std::cout << "[" << id << "] "
+                  << btfparse::IBTF::getBTFTypeKind(btf_type) << " "
+                  << btf_type << "\n";
+
+        return true;
+      });
 
-    std::cout << "[" << id << "] " << btfparse::IBTF::getBTFTypeKind(btf_type)
-              << " " << btf_type << "\n";
+  if (opt_error.has_value()) {
+    std::cerr << "Failed to enumerate the types: " << opt_error.value()
+              << "\n";
+    return 1;
   }
 
   return 0;